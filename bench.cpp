@@ -0,0 +1,832 @@
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <latch>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "units_atomic.hpp"
+#include "units_bulk.hpp"
+#include "units_expr.hpp"
+#include "units_file.hpp"
+#include "units_format.hpp"
+#include "units_histogram.hpp"
+#include "units_id.hpp"
+#include "units_log.hpp"
+#include "units_numeric.hpp"
+#include "units_parallel.hpp"
+#include "units_sketch.hpp"
+
+SU_DURATION_UNIT(second_t, "s")
+SU_UNIT(watt_t, "W")
+SU_UNIT(joule_t, "J")
+SU_MUL(second_t, watt_t, joule_t)
+
+// Build with optimisations and the target instruction set, e.g.
+// g++ -std=c++20 -O3 -march=native bench.cpp -o bench
+
+namespace
+{
+
+constexpr std::size_t n_elements = 1 << 12;
+constexpr int n_repeats = 2000;
+
+// Returns the best observed time per element, in nanoseconds
+template <typename F>
+double time_per_element(F&& f, std::size_t n = n_elements, int repeats = n_repeats) {
+    double best = 1e300;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / n);
+    }
+    return best;
+}
+
+void report(const char* name, double baseline, double candidate) {
+    std::printf("%-44s %8.3f ns %8.3f ns %6.2fx\n", name, baseline, candidate, baseline / candidate);
+}
+
+// Prevents the compiler from discarding stores to p
+void clobber(const void* p) {
+    asm volatile("" : : "r"(p) : "memory");
+}
+
+template <typename U>
+std::vector<U> make_input(std::size_t n = n_elements) {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> dist(-1'000'000, 1'000'000);
+
+    std::vector<U> in(n);
+    for (auto& x : in) {
+        x = U(static_cast<typename U::rep>(dist(rng)));
+    }
+    return in;
+}
+
+template <typename From, typename To>
+void bench_unit_cast(const char* name) {
+    auto in = make_input<From>();
+    std::vector<To> out(n_elements);
+
+    double scalar = time_per_element([&] {
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            out[i] = su::unit_cast<To>(in[i]);
+        }
+        clobber(out.data());
+    });
+    double bulk = time_per_element([&] {
+        su::unit_cast(std::span(std::as_const(in)), std::span(out));
+        clobber(out.data());
+    });
+
+    report(name, scalar, bulk);
+}
+
+template <typename From, typename To>
+void bench_fast_math(const char* name) {
+    auto in = make_input<From>();
+    std::vector<To> strict(n_elements);
+    std::vector<To> fast(n_elements);
+
+    double strict_time = time_per_element([&] {
+        su::unit_cast(std::span(std::as_const(in)), std::span(strict), su::strict);
+        clobber(strict.data());
+    });
+    double fast_time = time_per_element([&] {
+        su::unit_cast(std::span(std::as_const(in)), std::span(fast), su::fast_math);
+        clobber(fast.data());
+    });
+
+    int64_t max_ulp = 0;
+    for (std::size_t i = 0; i < n_elements; ++i) {
+        auto a = std::bit_cast<int64_t>(strict[i].count());
+        auto b = std::bit_cast<int64_t>(fast[i].count());
+        max_ulp = std::max(max_ulp, a > b ? a - b : b - a);
+    }
+
+    std::printf("%-44s %8.3f ns %8.3f ns %6.2fx %4lld ulp\n", name, strict_time, fast_time, strict_time / fast_time, static_cast<long long>(max_ulp));
+}
+
+// Compares unit_cast on int64 reps with the unchecked single multiply it used
+// to perform, and with always widening the product to 128 bits
+template <typename From, typename To>
+void bench_safe_cast(const char* name) {
+    using R = std::ratio_divide<typename To::scale, typename From::scale>;
+    __extension__ using int128 = __int128;
+
+    auto in = make_input<From>();
+    std::vector<To> out(n_elements);
+
+    double naive = time_per_element([&] {
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            out[i] = To((in[i].count() * R::den) / R::num);
+        }
+        clobber(out.data());
+    });
+    double wide = time_per_element([&] {
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            out[i] = To(static_cast<int64_t>((int128(in[i].count()) * R::den) / R::num));
+        }
+        clobber(out.data());
+    });
+    double safe = time_per_element([&] {
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            out[i] = su::unit_cast<To>(in[i]);
+        }
+        clobber(out.data());
+    });
+
+    std::printf("%-44s %8.3f ns %8.3f ns %8.3f ns\n", name, naive, wide, safe);
+}
+
+template <typename U>
+su::unit_vector<typename U::tag, typename U::rep, typename U::scale> to_unit_vector(const std::vector<U>& v) {
+    su::unit_vector<typename U::tag, typename U::rep, typename U::scale> out(v.size());
+    std::copy(v.begin(), v.end(), out.begin());
+    return out;
+}
+
+// Compares a loop over std::vector<unit> with the equivalent unit_vector
+// operator. Both sides allocate their result.
+template <typename A, typename B, typename Op>
+void bench_unit_vector(const char* name, Op op) {
+    auto a = make_input<A>();
+    auto b = make_input<B>();
+    auto va = to_unit_vector(a);
+    auto vb = to_unit_vector(b);
+
+    double loop = time_per_element([&] {
+        std::vector<decltype(op(a[0], b[0]))> out(a.size());
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            out[i] = op(a[i], b[i]);
+        }
+        clobber(out.data());
+    });
+    double vec = time_per_element([&] {
+        auto out = op(va, vb);
+        clobber(out.raw().data());
+    });
+
+    report(name, loop, vec);
+}
+
+// Sums a large array after converting it to another scale: by materializing a
+// converted copy, through the lazy view one element at a time, and through the
+// lazy view in cache-sized chunks converted with the bulk kernels
+void bench_lazy_cast() {
+    using From = su::unit<watt_t, int32_t, std::milli>;
+    using To = su::unit_d<watt_t, std::kilo>;
+    constexpr std::size_t n = 1 << 24;
+    constexpr int repeats = 10;
+    auto in = make_input<From>(n);
+
+    double copy = time_per_element([&] {
+        std::vector<To> out(n);
+        su::unit_cast(std::span(std::as_const(in)), std::span(out));
+        double sum = 0;
+        for (auto x : out) {
+            sum += x.count();
+        }
+        clobber(&sum);
+    }, n, repeats);
+    double lazy = time_per_element([&] {
+        double sum = 0;
+        for (auto x : in | su::views::unit_cast<To>) {
+            sum += x.count();
+        }
+        clobber(&sum);
+    }, n, repeats);
+    double chunked = time_per_element([&] {
+        std::array<To, 4096> buffer;
+        double sum = 0;
+        for (auto chunk : in | su::views::unit_cast<To> | su::views::chunk(buffer.size())) {
+            for (auto x : chunk.convert(buffer)) {
+                sum += x.count();
+            }
+        }
+        clobber(&sum);
+    }, n, repeats);
+
+    std::printf("%-44s %8.3f ns\n", "materialized copy", copy);
+    std::printf("%-44s %8.3f ns\n", "lazy view", lazy);
+    std::printf("%-44s %8.3f ns\n", "lazy view, chunks of 4096", chunked);
+}
+
+// (kW + W) * s / MJ, evaluated eagerly and as a single folded expression
+void bench_expression() {
+    auto a = make_input<su::unit_d<watt_t, std::kilo>>();
+    auto b = make_input<su::unit_d<watt_t>>();
+    auto c = make_input<su::unit_d<second_t>>();
+    auto d = make_input<su::unit_d<joule_t, std::mega>>();
+    std::vector<double> out(n_elements);
+
+    double eager = time_per_element([&] {
+        for (std::size_t i = 0; i < n_elements; ++i) {
+            out[i] = (a[i] + b[i]) * c[i] / d[i];
+        }
+        clobber(out.data());
+    });
+    double folded = time_per_element([&] {
+        for (std::size_t i = 0; i < n_elements; ++i) {
+            out[i] = (su::expr::lazy(a[i]) + b[i]) * c[i] / d[i];
+        }
+        clobber(out.data());
+    });
+
+    report("(kW + W) * s / MJ", eager, folded);
+
+    auto e = make_input<su::unit_d<watt_t, std::milli>>();
+    auto f = make_input<su::unit_d<second_t, std::milli>>();
+    std::vector<su::unit_d<joule_t, std::mega>> energy(n_elements);
+
+    eager = time_per_element([&] {
+        for (std::size_t i = 0; i < n_elements; ++i) {
+            energy[i] = su::unit_cast<su::unit_d<joule_t, std::mega>>((a[i] + b[i] + e[i]) * f[i]);
+        }
+        clobber(energy.data());
+    });
+    folded = time_per_element([&] {
+        for (std::size_t i = 0; i < n_elements; ++i) {
+            energy[i] = (su::expr::lazy(a[i]) + b[i] + e[i]) * f[i];
+        }
+        clobber(energy.data());
+    });
+
+    report("(kW + W + mW) * ms -> MJ", eager, folded);
+}
+
+// Formats every element, one per line, into a reused stream or buffer
+template <typename U>
+void bench_format(const char* name) {
+    auto in = make_input<U>();
+    for (auto& x : in) {
+        x /= 7;
+    }
+    std::ostringstream stream;
+    std::vector<char> buffer(in.size() * 64);
+
+    double ostream = time_per_element([&] {
+        stream.str({});
+        for (const auto& x : in) {
+            stream << x << '\n';
+        }
+        clobber(stream.str().data());
+    }, n_elements, 200);
+    double to_chars = time_per_element([&] {
+        char* p = buffer.data();
+        char* last = buffer.data() + buffer.size();
+        for (const auto& x : in) {
+            p = su::to_chars(p, last, x).ptr;
+            *p++ = '\n';
+        }
+        clobber(buffer.data());
+    }, n_elements, 200);
+#if defined(__cpp_lib_format)
+    double format = time_per_element([&] {
+        char* p = buffer.data();
+        for (const auto& x : in) {
+            p = std::format_to(p, "{}\n", x);
+        }
+        clobber(buffer.data());
+    }, n_elements, 200);
+    std::printf("%-44s %8.3f ns %8.3f ns %8.3f ns %6.2fx\n", name, ostream, to_chars, format, ostream / to_chars);
+#else
+    std::printf("%-44s %8.3f ns %8.3f ns %11s %6.2fx\n", name, ostream, to_chars, "-", ostream / to_chars);
+#endif
+}
+
+// Parses newline-separated power readings with mixed prefixes into mW
+void bench_parse() {
+    using milliwatts = su::unit_d<watt_t, std::milli>;
+    auto in = make_input<su::unit_i<watt_t>>();
+    std::string text;
+    const char* prefixes[] = {"k", "", "m"};
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        text += std::to_string(in[i].count() / 1000.0) + (i % 2 ? " " : "") + prefixes[i % 3] + "W\n";
+    }
+    std::vector<milliwatts> out(in.size());
+
+    double naive = time_per_element([&] {
+        const char* p = text.data();
+        const char* last = text.data() + text.size();
+        for (auto& x : out) {
+            const char* end = static_cast<const char*>(std::memchr(p, '\n', std::size_t(last - p)));
+            std::string line(p, end);
+            char* suffix_start;
+            double v = std::strtod(line.c_str(), &suffix_start);
+            std::string suffix(suffix_start);
+            suffix.erase(0, suffix.find_first_not_of(' '));
+            if (suffix == "kW") {
+                v *= 1e6;
+            } else if (suffix == "W") {
+                v *= 1e3;
+            } else if (suffix != "mW") {
+                std::abort();
+            }
+            x = milliwatts(v);
+            p = end + 1;
+        }
+        clobber(out.data());
+    }, n_elements, 200);
+    double parsed = time_per_element([&] {
+        if (su::from_chars(text.data(), text.data() + text.size(), std::span(out)).ec != su::parse_errc::ok) {
+            std::abort();
+        }
+        clobber(out.data());
+    }, n_elements, 200);
+
+    report("\"-123.456 kW\" lines -> double mW", naive, parsed);
+}
+
+// Looks up the ids of 256 registered types in a random order
+template <std::size_t... I>
+void bench_type_lookup(std::index_sequence<I...>) {
+    using types = std::tuple<su::unit<watt_t, int32_t, std::ratio<I + 1>>...>;
+    su::type_registry registry;
+    std::unordered_map<std::uint64_t, const su::unit_type_info*> map;
+    (registry.add<std::tuple_element_t<I, types>>(), ...);
+    (map.emplace(su::type_id<std::tuple_element_t<I, types>>, &su::type_info_of<std::tuple_element_t<I, types>>), ...);
+
+    std::uint64_t ids[] = {su::type_id<std::tuple_element_t<I, types>>...};
+    std::vector<std::uint64_t> in(n_elements);
+    std::mt19937_64 rng(42);
+    for (auto& id : in) {
+        id = ids[rng() % sizeof...(I)];
+    }
+    std::vector<const su::unit_type_info*> out(n_elements);
+
+    double unordered = time_per_element([&] {
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            out[i] = map.find(in[i])->second;
+        }
+        clobber(out.data());
+    });
+    double perfect = time_per_element([&] {
+        for (std::size_t i = 0; i < in.size(); ++i) {
+            out[i] = registry.find(in[i]);
+        }
+        clobber(out.data());
+    });
+
+    report("256 types", unordered, perfect);
+}
+
+// Loads 2^20 readings from a text file already in memory, against opening a
+// series file and viewing or converting its column. The series file is in the
+// page cache, so this measures the cost of loading rather than of the disk.
+void bench_series() {
+    using milliwatts = su::unit_i<watt_t, std::milli>;
+    using microwatts = su::unit_i<watt_t, std::micro>;
+    constexpr std::size_t n = 1 << 20;
+    auto in = make_input<milliwatts>(n);
+    std::string text;
+    char line[32];
+    for (const auto& x : in) {
+        text.append(line, su::to_chars(line, line + sizeof(line), x).ptr);
+        text += '\n';
+    }
+    auto path = std::filesystem::temp_directory_path() / "su_bench_series.bin";
+    const su::series_column columns[] = {su::make_series_column("power", std::span(in))};
+    if (su::write_series(path, columns) != su::file_errc::ok) {
+        std::abort();
+    }
+    std::vector<milliwatts> parsed(n);
+    std::vector<microwatts> converted(n);
+    volatile int64_t sink = 0;
+
+    double text_ns = time_per_element([&] {
+        if (su::from_chars(text.data(), text.data() + text.size(), std::span(parsed)).count != n) {
+            std::abort();
+        }
+        clobber(parsed.data());
+    }, n, 20);
+    double view_ns = time_per_element([&] {
+        su::series_file file;
+        if (file.open(path) != su::file_errc::ok) {
+            std::abort();
+        }
+        auto view = file.view<milliwatts>("power");
+        sink = view.values[n - 1].count();
+    }, n, 20);
+    double read_ns = time_per_element([&] {
+        su::series_file file;
+        if (file.open(path) != su::file_errc::ok || file.read("power", std::span(converted)).ec != su::file_errc::ok) {
+            std::abort();
+        }
+        clobber(converted.data());
+    }, n, 20);
+    std::filesystem::remove(path);
+
+    report("int64 mW: text -> view", text_ns, view_ns);
+    report("int64 mW: text -> read as uW", text_ns, read_ns);
+}
+
+// Returns the wall time per operation of n_threads threads each calling f
+// n_ops times, in nanoseconds
+template <typename F>
+double contended(int n_threads, int n_ops, F&& f) {
+    std::latch start(n_threads + 1);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < n_threads; ++t) {
+        threads.emplace_back([&] {
+            start.arrive_and_wait();
+            for (int i = 0; i < n_ops; ++i) {
+                f();
+            }
+        });
+    }
+    auto begin = std::chrono::steady_clock::now();
+    start.arrive_and_wait();
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / (double(n_threads) * n_ops);
+}
+
+// Adds kJ to a shared J counter from 1 to 64 threads
+void bench_atomic() {
+    using joules = su::unit_i<joule_t>;
+    using joules_d = su::unit_d<joule_t>;
+    constexpr int n_ops = 1 << 16;
+    for (int n_threads = 1; n_threads <= 64; n_threads *= 2) {
+        std::mutex mutex;
+        joules locked{};
+        std::atomic<joules> total{};
+        std::atomic<joules_d> total_d{};
+        su::unit_i<joule_t, std::kilo> kj(1);
+
+        double mutex_ns = contended(n_threads, n_ops, [&] {
+            std::lock_guard lock(mutex);
+            locked += kj;
+        });
+        double int_ns = contended(n_threads, n_ops, [&] { total.fetch_add(kj, std::memory_order_relaxed); });
+        double double_ns = contended(n_threads, n_ops, [&] { total_d.fetch_add(kj, std::memory_order_relaxed); });
+        if (total.load() != locked || total_d.load() != joules_d(locked)) {
+            std::abort();
+        }
+        std::printf("%-44d %8.3f ns %8.3f ns %8.3f ns\n", n_threads, mutex_ns, int_ns, double_ns);
+    }
+}
+
+// Adds kJ to a J counter from 1 to 64 threads, through one atomic or shards
+void bench_sharded() {
+    using joules = su::unit_i<joule_t>;
+    constexpr int n_ops = 1 << 16;
+    for (int n_threads = 1; n_threads <= 64; n_threads *= 2) {
+        std::atomic<joules> total{};
+        su::sharded_counter<joules> sharded;
+        su::unit_i<joule_t, std::kilo> kj(1);
+
+        double atomic_ns = contended(n_threads, n_ops, [&] { total.fetch_add(kj, std::memory_order_relaxed); });
+        double sharded_ns = contended(n_threads, n_ops, [&] { sharded += kj; });
+        if (sharded.load() != total.load()) {
+            std::abort();
+        }
+        report(std::to_string(n_threads).c_str(), atomic_ns, sharded_ns);
+    }
+}
+
+// Sums watts of widely varying magnitude with each strategy, and reports the
+// time per element and the relative error against a long double sum
+void bench_sum() {
+    using watts = su::unit_d<watt_t>;
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> mantissa(-1, 1);
+    std::uniform_int_distribution<int> exponent(-20, 20);
+    std::vector<watts> in(1 << 16);
+    long double exact = 0;
+    for (auto& x : in) {
+        x = watts(std::ldexp(mantissa(rng), exponent(rng)));
+        exact += x.count();
+    }
+
+    auto run = [&](const char* name, auto strategy) {
+        watts total{};
+        double ns = time_per_element([&] {
+            total = su::sum(in, strategy);
+            clobber(&total);
+        }, in.size(), 200);
+        double error = double(std::abs((total.count() - exact) / exact));
+        std::printf("%-44s %8.3f ns %11.2e\n", name, ns, error);
+    };
+    run("naive", su::naive);
+    run("kahan", su::kahan);
+    run("neumaier", su::neumaier);
+    run("pairwise", su::pairwise);
+}
+
+// Sums integer units in a wider rep, with a scalar loop and su::accumulate
+template <typename U>
+void bench_accumulate(const char* name) {
+    using Acc = su::accumulator_rep_t<typename U::rep>;
+    auto in = make_input<U>(1 << 16);
+
+    Acc scalar_total = 0;
+    double scalar = time_per_element([&] {
+        Acc total = 0;
+        for (const auto& x : in) {
+            total += x.count();
+        }
+        scalar_total = total;
+        clobber(&scalar_total);
+    }, in.size(), 200);
+
+    Acc lanes_total = 0;
+    double lanes = time_per_element([&] {
+        lanes_total = su::accumulate(in).count();
+        clobber(&lanes_total);
+    }, in.size(), 200);
+
+    if (scalar_total != lanes_total) {
+        std::abort();
+    }
+    report(name, scalar, lanes);
+}
+
+// Welford's update for each element against su::statistics, which takes
+// blocks in vector lanes
+template <typename U>
+void bench_statistics(const char* name) {
+    auto in = make_input<U>(1 << 16);
+
+    su::welford_accumulator<U> scalar_result;
+    double scalar = time_per_element([&] {
+        su::welford_accumulator<U> acc;
+        for (const auto& x : in) {
+            acc += x;
+        }
+        scalar_result = acc;
+        clobber(&scalar_result);
+    }, in.size(), 200);
+
+    su::welford_accumulator<U> lanes_result;
+    double lanes = time_per_element([&] {
+        lanes_result = su::statistics(in);
+        clobber(&lanes_result);
+    }, in.size(), 200);
+
+    if (scalar_result.min() != lanes_result.min() ||
+        std::abs(scalar_result.stddev().count() - lanes_result.stddev().count()) > 1e-9 * scalar_result.stddev().count()) {
+        std::abort();
+    }
+    report(name, scalar, lanes);
+}
+
+// Runs the parallel bulk operations over 2^24 elements on pools of 1 to 64
+// threads. Beyond the number of cores, more threads only add overhead.
+void bench_parallel() {
+    using milliwatts = su::unit<watt_t, int32_t, std::milli>;
+    using kilowatts = su::unit_d<watt_t, std::kilo>;
+    constexpr std::size_t n = 1 << 24;
+    constexpr int repeats = 10;
+    auto in = make_input<milliwatts>(n);
+    std::vector<kilowatts> power(n);
+    std::vector<su::unit_d<second_t>> durations(n, su::unit_d<second_t>(0.5));
+    std::vector<su::unit_d<joule_t, std::kilo>> energy(n);
+
+    for (std::size_t n_threads = 1; n_threads <= 64; n_threads *= 2) {
+        su::thread_pool pool(n_threads);
+        double convert = time_per_element([&] {
+            su::parallel::unit_cast(std::span(std::as_const(in)), std::span(power), su::strict, pool);
+            clobber(power.data());
+        }, n, repeats);
+        double multiply = time_per_element([&] {
+            su::parallel::multiply(std::span(std::as_const(power)), std::span(std::as_const(durations)), std::span(energy), pool);
+            clobber(energy.data());
+        }, n, repeats);
+        double sum = time_per_element([&] {
+            auto total = su::parallel::sum(std::span(std::as_const(power)), su::neumaier, pool);
+            clobber(&total);
+        }, n, repeats);
+        double accumulate = time_per_element([&] {
+            auto total = su::parallel::accumulate(std::span(std::as_const(in)), pool);
+            clobber(&total);
+        }, n, repeats);
+        double minmax = time_per_element([&] {
+            auto range = su::parallel::minmax(std::span(std::as_const(in)), pool);
+            clobber(&range);
+        }, n, repeats);
+        std::printf("%-20zu %8.3f ns %8.3f ns %8.3f ns %8.3f ns %8.3f ns\n", n_threads, convert, multiply, sum, accumulate, minmax);
+    }
+}
+
+// Records nanosecond latencies into a histogram, against adding them to an
+// untyped array of atomic counters indexed the same way. Also times a p99
+// query on a snapshot.
+void bench_histogram() {
+    using nanoseconds = su::unit<second_t, int64_t, std::nano>;
+    using microseconds = su::unit<second_t, int64_t, std::micro>;
+    auto in = make_input<nanoseconds>();
+    for (auto& x : in) {
+        x = nanoseconds(std::abs(x.count()));
+    }
+
+    auto raw = std::make_unique<std::atomic<std::uint64_t>[]>(su::histogram<nanoseconds>::bucket_count);
+    double untyped = time_per_element([&] {
+        for (const auto& x : in) {
+            raw[su::detail::histogram_bucket<7>(std::uint64_t(x.count()))].fetch_add(1, std::memory_order_relaxed);
+        }
+    }, n_elements, 200);
+
+    su::histogram<nanoseconds> h;
+    double typed = time_per_element([&] {
+        for (const auto& x : in) {
+            h.record(x);
+        }
+    }, n_elements, 200);
+    report("int64 ns", untyped, typed);
+
+    su::histogram<microseconds> coarse;
+    double converted = time_per_element([&] {
+        for (const auto& x : in) {
+            coarse.record(x);
+        }
+    }, n_elements, 200);
+    report("int64 ns into a us histogram", untyped, converted);
+
+    su::local_histogram<nanoseconds> local;
+    double single_writer = time_per_element([&] {
+        for (const auto& x : in) {
+            local.record(x);
+        }
+    }, n_elements, 200);
+    report("int64 ns, local_histogram", untyped, single_writer);
+
+    double query = time_per_element([&] {
+        auto p99 = h.snapshot().percentile(99);
+        clobber(&p99);
+    }, 1, 200);
+    std::printf("%-44s %8.3f us\n", "snapshot and p99", query / 1000);
+}
+
+// Logs nanosecond timings into the binary log, against formatting them. The
+// ring is drained between repeats, outside the timed region.
+void bench_log() {
+    using nanoseconds = su::unit<second_t, int64_t, std::nano>;
+    auto in = make_input<nanoseconds>();
+    std::vector<char> buffer(in.size() * 64);
+
+    double to_chars = time_per_element([&] {
+        char* p = buffer.data();
+        for (const auto& x : in) {
+            p = su::to_chars(p, buffer.data() + buffer.size(), x).ptr;
+        }
+        clobber(buffer.data());
+    }, n_elements, 200);
+
+    su::binlog::attach();
+    double logged = 1e300;
+    for (int i = 0; i < n_repeats; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        for (const auto& x : in) {
+            su::binlog::write(x);
+        }
+        auto end = std::chrono::steady_clock::now();
+        logged = std::min(logged, std::chrono::duration<double, std::nano>(end - start).count() / n_elements);
+        su::binlog::drain([](const su::binlog::record&) {});
+    }
+    if (su::binlog::dropped() != 0) {
+        std::abort();
+    }
+
+    report("int64 ns", to_chars, logged);
+}
+
+} // namespace
+
+// Inserts a million log-normal latencies, from about 10 us to 10 ms, into
+// sketches of two accuracies, and reports the time per insert and the memory
+// the sketch takes in buckets and serialized
+void bench_sketch() {
+    using nanoseconds = su::unit<second_t, double, std::nano>;
+    using microseconds = su::unit<second_t, int64_t, std::micro>;
+    constexpr std::size_t n = 1'000'000;
+    std::mt19937_64 rng(42);
+    std::lognormal_distribution<double> dist(std::log(300'000.0), 1.0);
+    std::vector<nanoseconds> in(n);
+    for (auto& x : in) {
+        x = nanoseconds(dist(rng));
+    }
+
+    auto row = [&](const char* name, double accuracy, std::size_t max_buckets) {
+        su::ddsketch<nanoseconds> s(accuracy, max_buckets);
+        double insert = time_per_element([&] {
+            s = su::ddsketch<nanoseconds>(accuracy, max_buckets);
+            for (const auto& x : in) {
+                s.add(x);
+            }
+            clobber(&s);
+        }, n, 10);
+        std::printf("%-44s %8.3f ns %8zu B %8zu B\n", name, insert, s.bucket_count() * sizeof(std::uint64_t), s.serialize().size());
+    };
+    row("double ns, 1% accuracy", 0.01, 2048);
+    row("double ns, 0.1% accuracy", 0.001, 8192);
+    row("double ns, 0.1% accuracy, folded to 2048", 0.001, 2048);
+
+    su::ddsketch<microseconds> coarse(0.01);
+    double converted = time_per_element([&] {
+        coarse = su::ddsketch<microseconds>(0.01);
+        for (const auto& x : in) {
+            coarse.add(x);
+        }
+        clobber(&coarse);
+    }, n, 10);
+    std::printf("%-44s %8.3f ns %8zu B %8zu B\n", "double ns into an int64 us sketch, 1%", converted,
+        coarse.bucket_count() * sizeof(std::uint64_t), coarse.serialize().size());
+}
+
+int main() {
+    std::printf("%-44s %11s %11s %7s\n", "unit_cast", "scalar", "bulk", "speedup");
+    bench_unit_cast<su::unit<watt_t, int32_t, std::milli>, su::unit_d<watt_t, std::kilo>>("int32 mW -> double kW");
+    bench_unit_cast<su::unit_d<watt_t>, su::unit_d<watt_t, std::milli>>("double W -> double mW");
+    bench_unit_cast<su::unit_d<watt_t, std::milli>, su::unit<watt_t, float>>("double mW -> float W");
+    bench_unit_cast<su::unit_i<watt_t, std::kilo>, su::unit_i<watt_t>>("int64 kW -> int64 W");
+    bench_unit_cast<su::unit<watt_t, int32_t, std::kilo>, su::unit<watt_t, int32_t>>("int32 kW -> int32 W");
+    bench_unit_cast<su::unit_i<watt_t>, su::unit_i<watt_t, std::kilo>>("int64 W -> int64 kW");
+
+    std::printf("\n%-44s %11s %11s %7s %8s\n", "unit_cast (double)", "strict", "fast_math", "speedup", "max err");
+    bench_fast_math<su::unit_d<watt_t>, su::unit_d<watt_t, std::kilo>>("W -> kW");
+    bench_fast_math<su::unit_d<watt_t, std::milli>, su::unit_d<watt_t, std::kilo>>("mW -> kW");
+    bench_fast_math<su::unit_d<watt_t, std::nano>, su::unit_d<watt_t>>("nW -> W");
+    bench_fast_math<su::unit_d<watt_t>, su::unit_d<watt_t, std::ratio<3600>>>("W -> [3600]W");
+    bench_fast_math<su::unit_d<watt_t, std::kilo>, su::unit_d<watt_t, std::milli>>("kW -> mW");
+
+    std::printf("\n%-44s %11s %11s %11s\n", "unit_cast (int64)", "unchecked", "int128", "unit_cast");
+    bench_safe_cast<su::unit_i<watt_t, std::kilo>, su::unit_i<watt_t, std::milli>>("kW -> mW");
+    bench_safe_cast<su::unit_i<watt_t, std::micro>, su::unit_i<watt_t, std::milli>>("uW -> mW");
+    bench_safe_cast<su::unit_i<watt_t, std::nano>, su::unit_i<watt_t, std::kilo>>("nW -> kW");
+    bench_safe_cast<su::unit_i<watt_t, std::ratio<1, 3>>, su::unit_i<watt_t, std::milli>>("[1/3]W -> mW (split multiply)");
+    bench_safe_cast<su::unit_i<watt_t, std::ratio<1'000'000'007>>, su::unit_i<watt_t, std::ratio<999'999'937>>>("[1000000007]W -> [999999937]W (split multiply)");
+
+    std::printf("\n%-44s %11s %11s %7s\n", "unit_vector", "loop", "operator", "speedup");
+    bench_unit_vector<su::unit_d<watt_t, std::kilo>, su::unit_d<watt_t>>("double kW + double W", std::plus<>());
+    bench_unit_vector<su::unit_d<watt_t>, su::unit_d<watt_t>>("double W - double W", std::minus<>());
+    bench_unit_vector<su::unit<watt_t, int32_t>, su::unit<watt_t, int32_t>>("int32 W + int32 W", std::plus<>());
+    bench_unit_vector<su::unit_d<watt_t, std::kilo>, su::unit_d<second_t>>("double kW * double s", std::multiplies<>());
+    bench_unit_vector<su::unit_d<watt_t>, su::unit_d<watt_t>>("double W * 2.5", [](const auto& a, const auto&) { return a * 2.5; });
+
+    std::printf("\n%-44s %11s\n", "sum of int32 mW as double kW (2^24 elements)", "time");
+    bench_lazy_cast();
+
+    std::printf("\n%-44s %11s %11s %7s\n", "expression (double)", "eager", "folded", "speedup");
+    bench_expression();
+
+    std::printf("\n%-44s %11s %11s %11s %7s\n", "format", "ostream", "to_chars", "format_to", "speedup");
+    bench_format<su::unit_i<watt_t, std::kilo>>("int64 kW");
+    bench_format<su::unit_d<watt_t, std::milli>>("double mW");
+    bench_format<su::unit<joule_t, int32_t, std::ratio<3600>>>("int32 [3600]J");
+
+    std::printf("\n%-44s %11s %11s %7s\n", "parse", "strtod", "from_chars", "speedup");
+    bench_parse();
+
+    std::printf("\n%-44s %11s %11s %7s\n", "load", "from_chars", "series", "speedup");
+    bench_series();
+
+    std::printf("\n%-44s %11s %11s %7s\n", "type lookup", "map", "registry", "speedup");
+    bench_type_lookup(std::make_index_sequence<256>());
+
+    std::printf("\n%-44s %11s %11s %11s\n", "kJ into J counter (threads)", "mutex", "int64", "double");
+    bench_atomic();
+
+    std::printf("\n%-44s %11s %11s %7s\n", "kJ into J counter (threads)", "atomic", "sharded", "speedup");
+    bench_sharded();
+
+    std::printf("\n%-44s %11s %11s\n", "sum of 2^16 double W", "time", "rel error");
+    bench_sum();
+
+    std::printf("\n%-44s %11s %11s %7s\n", "accumulate (2^16 elements)", "scalar", "accumulate", "speedup");
+    bench_accumulate<su::unit<watt_t, int32_t, std::milli>>("int32 mW in int64");
+    bench_accumulate<su::unit<watt_t, uint32_t, std::milli>>("uint32 mW in uint64");
+    bench_accumulate<su::unit<watt_t, int64_t, std::milli>>("int64 mW in int128");
+
+    std::printf("\n%-44s %11s %11s %7s\n", "statistics (2^16 elements)", "Welford", "statistics", "speedup");
+    bench_statistics<su::unit<watt_t, double>>("double W");
+    bench_statistics<su::unit<watt_t, int32_t, std::milli>>("int32 mW");
+
+    std::printf("\n%-20s %11s %11s %11s %11s %11s\n", "parallel (threads)", "convert", "multiply", "sum", "accumulate", "minmax");
+    bench_parallel();
+
+    std::printf("\n%-44s %11s %11s %7s\n", "histogram record", "untyped", "histogram", "speedup");
+    bench_histogram();
+
+    std::printf("\n%-44s %11s %10s %10s\n", "sketch of 10^6 latencies", "insert", "buckets", "serialized");
+    bench_sketch();
+
+    std::printf("\n%-44s %11s %11s %7s\n", "log", "to_chars", "binlog", "speedup");
+    bench_log();
+}
@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "units.hpp"
+#include "units_point.hpp"
+
+SU_DURATION_UNIT(second_t, "s")
+SU_UNIT(watt_t, "W")
+SU_UNIT(joule_t, "J")
+SU_MUL(second_t, watt_t, joule_t)
+
+// Kernels written once with su::unit and once with the raw rep, for
+// codegen_check.py to compare. Each pair must compute the same values, so any
+// difference in instructions or time is overhead added by the library.
+// Build with e.g. g++ -std=c++20 -O2 codegen.cpp -o codegen
+
+#if defined(__clang__)
+#define SU_KERNEL extern "C" __attribute__((noinline))
+#else
+#define SU_KERNEL extern "C" __attribute__((noipa))
+#endif
+
+using ms = su::unit<second_t, int64_t, std::milli>;
+using s = su::unit<second_t, int64_t>;
+using us = su::unit<second_t, int64_t, std::micro>;
+using kw = su::unit<watt_t, int64_t, std::kilo>;
+using j = su::unit<joule_t, int64_t>;
+using j_d = su::unit<joule_t, double>;
+using w_d = su::unit<watt_t, double>;
+using s_d = su::unit<second_t, double>;
+
+struct ptp_clock {};
+using ptp_ns = su::point<ptp_clock, su::unit<second_t, int64_t, std::nano>>;
+
+SU_KERNEL void unit_add(const ms* a, const ms* b, ms* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+SU_KERNEL void raw_add(const int64_t* a, const int64_t* b, int64_t* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = a[i] + b[i];
+    }
+}
+
+SU_KERNEL std::size_t unit_compare(const ms* a, const s* b, std::size_t n) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        count += a[i] < b[i];
+    }
+    return count;
+}
+
+SU_KERNEL std::size_t raw_compare(const int64_t* a, const int64_t* b, std::size_t n) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        count += a[i] < b[i] * 1000;
+    }
+    return count;
+}
+
+SU_KERNEL void unit_multiply(const ms* a, const kw* b, j* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+SU_KERNEL void raw_multiply(const int64_t* a, const int64_t* b, int64_t* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+SU_KERNEL void unit_multiply_double(const w_d* a, const s_d* b, j_d* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+SU_KERNEL void raw_multiply_double(const double* a, const double* b, double* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+SU_KERNEL void unit_convert(const ms* in, us* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = su::unit_cast<us>(in[i]);
+    }
+}
+
+SU_KERNEL void raw_convert(const int64_t* in, int64_t* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = in[i] * 1000;
+    }
+}
+
+SU_KERNEL void unit_chrono(const s* in, std::chrono::milliseconds* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = in[i];
+    }
+}
+
+SU_KERNEL void raw_chrono(const int64_t* in, int64_t* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = in[i] * 1000;
+    }
+}
+
+SU_KERNEL void unit_point_diff(const ptp_ns* a, const ptp_ns* b, su::unit<second_t, int64_t, std::nano>* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+SU_KERNEL void raw_point_diff(const int64_t* a, const int64_t* b, int64_t* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = a[i] - b[i];
+    }
+}
+
+namespace
+{
+
+constexpr std::size_t n_elements = 1 << 12;
+constexpr int n_repeats = 5000;
+
+// Returns the time per element of f, in nanoseconds
+template <typename F>
+double time_per_element(F&& f) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / n_elements;
+}
+
+template <typename U>
+std::vector<U> make_input() {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<int> dist(-1'000'000, 1'000'000);
+
+    std::vector<U> in(n_elements);
+    for (auto& x : in) {
+        x = U(dist(rng));
+    }
+    return in;
+}
+
+// Views a raw buffer as units, which have the same layout as their rep
+template <typename T, typename V>
+T* as(V& v) {
+    static_assert(sizeof(T) == sizeof(*v.data()));
+    return reinterpret_cast<T*>(v.data());
+}
+
+// Prints "name unit_ns raw_ns" for codegen_check.py
+template <typename U, typename R>
+void report(const char* name, U&& unit_kernel, R&& raw_kernel) {
+    // Alternates between the kernels so that both see the same machine state,
+    // and keeps the best time of each
+    double unit_ns = 1e300;
+    double raw_ns = 1e300;
+    for (int i = 0; i < n_repeats; ++i) {
+        unit_ns = std::min(unit_ns, time_per_element(unit_kernel));
+        raw_ns = std::min(raw_ns, time_per_element(raw_kernel));
+    }
+    std::printf("%s %.4f %.4f\n", name, unit_ns, raw_ns);
+}
+
+} // namespace
+
+int main() {
+    auto a = make_input<int64_t>();
+    auto b = make_input<int64_t>();
+    auto da = make_input<double>();
+    auto db = make_input<double>();
+    std::vector<int64_t> out(n_elements);
+    std::vector<double> dout(n_elements);
+    volatile std::size_t sink = 0;
+
+    report("add",
+        [&] { unit_add(as<const ms>(a), as<const ms>(b), as<ms>(out), n_elements); },
+        [&] { raw_add(a.data(), b.data(), out.data(), n_elements); });
+    report("compare",
+        [&] { sink = unit_compare(as<const ms>(a), as<const s>(b), n_elements); },
+        [&] { sink = raw_compare(a.data(), b.data(), n_elements); });
+    report("multiply",
+        [&] { unit_multiply(as<const ms>(a), as<const kw>(b), as<j>(out), n_elements); },
+        [&] { raw_multiply(a.data(), b.data(), out.data(), n_elements); });
+    report("multiply_double",
+        [&] { unit_multiply_double(as<const w_d>(da), as<const s_d>(db), as<j_d>(dout), n_elements); },
+        [&] { raw_multiply_double(da.data(), db.data(), dout.data(), n_elements); });
+    report("convert",
+        [&] { unit_convert(as<const ms>(a), as<us>(out), n_elements); },
+        [&] { raw_convert(a.data(), out.data(), n_elements); });
+    report("chrono",
+        [&] { unit_chrono(as<const s>(a), as<std::chrono::milliseconds>(out), n_elements); },
+        [&] { raw_chrono(a.data(), out.data(), n_elements); });
+    report("point_diff",
+        [&] { unit_point_diff(as<const ptp_ns>(a), as<const ptp_ns>(b), as<su::unit<second_t, int64_t, std::nano>>(out), n_elements); },
+        [&] { raw_point_diff(a.data(), b.data(), out.data(), n_elements); });
+}
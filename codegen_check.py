@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""Checks that su::unit compiles to the same code as raw arithmetic.
+
+Builds codegen.cpp, which defines each kernel twice, as unit_<name> and
+raw_<name>. Reports the instruction count of both versions from the
+disassembly and their time per element from running the binary, and fails if
+the unit version has more instructions or is slower than the raw version by
+more than the tolerance.
+
+    python3 codegen_check.py [--cxx g++] [--flags="-O3 -march=native"] [--tolerance 0.05]
+"""
+
+import argparse
+import os
+import re
+import shlex
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def instruction_counts(binary):
+    # Number of instructions in each function of the disassembly
+    out = subprocess.run(["objdump", "-d", "--no-show-raw-insn", binary], capture_output=True, text=True, check=True).stdout
+    counts = {}
+    function = None
+    for line in out.splitlines():
+        header = re.match(r"^[0-9a-f]+ <(\w+)>:$", line)
+        if header:
+            function = header.group(1)
+            counts[function] = 0
+        elif function and re.match(r"^\s+[0-9a-f]+:\s+\S", line):
+            counts[function] += 1
+        elif not line.strip():
+            function = None
+    return counts
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--cxx", default=os.environ.get("CXX", "g++"))
+    parser.add_argument("--flags", default="-O2", help="compiler flags, e.g. --flags=\"-O3 -march=native\"")
+    parser.add_argument("--tolerance", type=float, default=0.05, help="allowed relative slowdown")
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        binary = os.path.join(tmp, "codegen")
+        subprocess.run([args.cxx, "-std=c++20", *shlex.split(args.flags), f"-I{HERE}", os.path.join(HERE, "codegen.cpp"), "-o", binary], check=True)
+        counts = instruction_counts(binary)
+        timings = subprocess.run([binary], capture_output=True, text=True, check=True).stdout
+
+    failed = []
+    print(f"{'kernel':<16} {'unit (insn)':>12} {'raw (insn)':>11} {'unit (ns)':>10} {'raw (ns)':>9}")
+    for line in timings.splitlines():
+        name, unit_ns, raw_ns = line.split()
+        unit_ns, raw_ns = float(unit_ns), float(raw_ns)
+        unit_insn = counts[f"unit_{name}"]
+        raw_insn = counts[f"raw_{name}"]
+        print(f"{name:<16} {unit_insn:>12} {raw_insn:>11} {unit_ns:>10.3f} {raw_ns:>9.3f}")
+        if unit_insn > raw_insn:
+            failed.append(f"{name}: {unit_insn} instructions, raw has {raw_insn}")
+        if unit_ns > raw_ns * (1 + args.tolerance):
+            failed.append(f"{name}: {unit_ns:.3f} ns per element, raw takes {raw_ns:.3f} ns")
+
+    for f in failed:
+        print(f"FAIL {f}", file=sys.stderr)
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,264 @@
+#!/usr/bin/env python3
+"""Compile-time benchmarks of the library.
+
+relations: compares relations declared with SU_MUL against dimension-vector
+    tags from units_dim.hpp, where the relations are derived. Generates TUs
+    with N relations of the form a_i * b = c_i and uses every product once.
+
+suite: generates TUs with N units, M relations and K mixed-scale expressions,
+    and records the wall time, peak compiler RSS, and instantiation counts of
+    su::unit, su::unit_cast, std::common_type and operator<=> for each
+    compiler. Clang counts come from -ftime-trace. GCC has no equivalent, so
+    its counts are the distinct instantiations emitted into the object file
+    at -O0, and std::common_type, which emits no code, is not counted.
+
+    python3 compile_bench.py relations [--cxx g++] [--relations 100 1000 10000]
+    python3 compile_bench.py suite [--cxx g++ clang++] [--units 300] [--relations 900] [--expressions 100 1000]
+"""
+
+import argparse
+import json
+import os
+import random
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+def specialized_source(n):
+    lines = ['#include "units.hpp"', "", "SU_UNIT(b_t, \"b\")"]
+    for i in range(n):
+        lines.append(f'SU_UNIT(a{i}_t, "a{i}")')
+        lines.append(f'SU_UNIT(c{i}_t, "c{i}")')
+        lines.append(f"SU_MUL(a{i}_t, b_t, c{i}_t)")
+    lines.append("")
+    lines.append("long long use() {")
+    lines.append("    long long sum = 0;")
+    lines.append("    su::unit<b_t, long long> b(2);")
+    for i in range(n):
+        lines.append(f"    sum += su::unit<c{i}_t, long long>(su::unit<a{i}_t, long long>({i}) * b).count();")
+    lines.append("    return sum;")
+    lines.append("}")
+    return "\n".join(lines) + "\n"
+
+
+def dim_exponents(i):
+    # Distinct exponent vectors over three base dimensions, none of them zero
+    return (i % 20 + 1, (i // 20) % 20 + 1, i // 400 + 1)
+
+
+def dim_source(n):
+    lines = ['#include "units_dim.hpp"', "", "using b_t = su::dim_t<1, 1, 1>;"]
+    for i in range(n):
+        x, y, z = dim_exponents(i)
+        lines.append(f"using a{i}_t = su::dim_t<{x}, {y}, {z}>;")
+        lines.append(f"using c{i}_t = su::dim_t<{x + 1}, {y + 1}, {z + 1}>;")
+    lines.append("")
+    lines.append("long long use() {")
+    lines.append("    long long sum = 0;")
+    lines.append("    su::unit<b_t, long long> b(2);")
+    for i in range(n):
+        lines.append(f"    sum += su::unit<c{i}_t, long long>(su::unit<a{i}_t, long long>({i}) * b).count();")
+    lines.append("    return sum;")
+    lines.append("}")
+    return "\n".join(lines) + "\n"
+
+
+SCALES = ["std::micro", "std::milli", "std::ratio<1>", "std::kilo", "std::ratio<60>", "std::ratio<3600>"]
+REPS = ["long long", "int", "double"]
+
+
+def choose_relations(n_units, n_relations, rng):
+    # SU_MUL(a, b, c) specializes mul<a, b>, mul<b, a>, div<c, a> and div<c, b>,
+    # so each of those has to be unique across the TU
+    used = set()
+    relations = []
+    attempts = 0
+    while len(relations) < n_relations:
+        attempts += 1
+        if attempts > 100 * n_relations + 1000:
+            raise SystemExit(f"cannot find {n_relations} distinct relations between {n_units} units")
+        a, b, c = rng.sample(range(n_units), 3)
+        keys = {("mul", a, b), ("mul", b, a), ("div", c, a), ("div", c, b)}
+        if used.isdisjoint(keys):
+            used |= keys
+            relations.append((a, b, c))
+    return relations
+
+
+def suite_source(n_units, n_relations, n_expressions, seed=1):
+    rng = random.Random(seed)
+    relations = choose_relations(n_units, n_relations, rng)
+
+    lines = ['#include "units.hpp"', ""]
+    lines += [f'SU_UNIT(u{i}_t, "u{i}")' for i in range(n_units)]
+    lines += [f"SU_MUL(u{a}_t, u{b}_t, u{c}_t)" for a, b, c in relations]
+    lines.append("")
+    lines.append("double use(double x) {")
+    lines.append("    double sum = 0;")
+
+    def u(tag, value):
+        rep = rng.choice(REPS)
+        return f"su::unit<u{tag}_t, {rep}, {rng.choice(SCALES)}>(static_cast<{rep}>({value}))"
+
+    # Cycles through products, sums with a conversion, and comparisons, with
+    # random reps and scales so that the common types differ
+    for k in range(n_expressions):
+        a, b, c = rng.choice(relations)
+        kind = k % 3
+        if kind == 0:
+            lines.append(f"    sum += su::unit<u{c}_t, double, {rng.choice(SCALES)}>({u(a, 'x')} * {u(b, k)}).count();")
+        elif kind == 1:
+            lines.append(f"    sum += su::unit<u{a}_t, double, {rng.choice(SCALES)}>({u(a, 'x')} + {u(a, k)} - {u(a, 1)}).count();")
+        else:
+            lines.append(f"    sum += ({u(c, 'x')} <=> {u(c, k)}) < 0 ? 1 : 0;")
+    lines.append("    return sum;")
+    lines.append("}")
+    return "\n".join(lines) + "\n"
+
+
+def run(cmd):
+    # Runs cmd and returns its wall time in seconds and peak RSS in MiB
+    start = time.perf_counter()
+    proc = subprocess.Popen(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
+    stderr = proc.stderr.read()
+    _, status, usage = os.wait4(proc.pid, 0)
+    wall = time.perf_counter() - start
+    proc.returncode = os.waitstatus_to_exitcode(status)
+    if proc.returncode != 0:
+        sys.stderr.write(stderr)
+        raise SystemExit(f"{' '.join(cmd)} failed")
+    return wall, usage.ru_maxrss / 1024
+
+
+def compile_time(cxx, path, repeats):
+    return min(run([cxx, "-std=c++20", "-fsyntax-only", f"-I{HERE}", path])[0] for _ in range(repeats))
+
+
+def is_clang(cxx):
+    out = subprocess.run([cxx, "--version"], capture_output=True, text=True).stdout
+    return "clang" in out
+
+
+def template_ids(text, prefix):
+    # Every balanced "prefix<...>" in text
+    ids = set()
+    start = text.find(prefix)
+    while start != -1:
+        depth = 0
+        for end in range(start + len(prefix) - 1, len(text)):
+            if text[end] == "<":
+                depth += 1
+            elif text[end] == ">":
+                depth -= 1
+                if depth == 0:
+                    ids.add(text[start:end + 1])
+                    break
+        start = text.find(prefix, start + 1)
+    return ids
+
+
+COUNTED = {
+    "unit": "su::unit<",
+    "unit_cast": "su::unit_cast<",
+    "common_type": "std::common_type<",
+    "operator<=>": "su::operator<=><",
+}
+
+
+def clang_counts(cxx, path, tmp):
+    obj = os.path.join(tmp, "trace.o")
+    subprocess.run([cxx, "-std=c++20", f"-I{HERE}", "-c", "-ftime-trace", "-ftime-trace-granularity=0",
+                    path, "-o", obj], check=True)
+    with open(os.path.join(tmp, "trace.json")) as f:
+        events = json.load(f)["traceEvents"]
+    counts = dict.fromkeys(COUNTED, 0)
+    for e in events:
+        if e.get("name") not in ("InstantiateClass", "InstantiateFunction"):
+            continue
+        detail = e.get("args", {}).get("detail", "")
+        for name, prefix in COUNTED.items():
+            if detail.startswith(prefix):
+                counts[name] += 1
+    return counts
+
+
+def gcc_counts(cxx, path, tmp):
+    obj = os.path.join(tmp, "symbols.o")
+    subprocess.run([cxx, "-std=c++20", f"-I{HERE}", "-c", "-O0", path, "-o", obj], check=True)
+    symbols = subprocess.run(["nm", "-C", "--defined-only", obj], capture_output=True, text=True, check=True).stdout
+    symbols = "\n".join(sorted({line.split(" ", 2)[-1] for line in symbols.splitlines()}))
+    counts = {}
+    counts["unit"] = len(template_ids(symbols, COUNTED["unit"]))
+    counts["unit_cast"] = sum(1 for line in symbols.splitlines() if " su::unit_cast<" in line)
+    counts["common_type"] = None
+    counts["operator<=>"] = sum(1 for line in symbols.splitlines() if " su::operator<=><" in line)
+    return counts
+
+
+def relations_main(args):
+    print(f"{'relations':>10} {'specialized (s)':>16} {'dim (s)':>10}")
+    with tempfile.TemporaryDirectory() as tmp:
+        for n in args.relations:
+            times = []
+            for name, generate in (("specialized", specialized_source), ("dim", dim_source)):
+                path = os.path.join(tmp, f"{name}_{n}.cpp")
+                with open(path, "w") as f:
+                    f.write(generate(n))
+                times.append(compile_time(args.cxx, path, args.repeats))
+            print(f"{n:>10} {times[0]:>16.2f} {times[1]:>10.2f}")
+
+
+def suite_main(args):
+    compilers = [c for c in args.cxx if shutil.which(c)]
+    for c in sorted(set(args.cxx) - set(compilers)):
+        print(f"skipping {c}: not found", file=sys.stderr)
+
+    header = f"{'compiler':>10} {'units':>6} {'rels':>6} {'exprs':>6} {'wall (s)':>9} {'RSS (MiB)':>10}"
+    header += "".join(f" {name:>12}" for name in COUNTED)
+    print(header)
+    with tempfile.TemporaryDirectory() as tmp:
+        for k in args.expressions:
+            path = os.path.join(tmp, f"suite_{args.units}_{args.relations}_{k}.cpp")
+            with open(path, "w") as f:
+                f.write(suite_source(args.units, args.relations, k))
+            for cxx in compilers:
+                results = [run([cxx, "-std=c++20", f"-I{HERE}", "-c", path, "-o", os.path.join(tmp, "suite.o")])
+                           for _ in range(args.repeats)]
+                wall = min(r[0] for r in results)
+                rss = max(r[1] for r in results)
+                counts = (clang_counts if is_clang(cxx) else gcc_counts)(cxx, path, tmp)
+                row = f"{os.path.basename(cxx):>10} {args.units:>6} {args.relations:>6} {k:>6} {wall:>9.2f} {rss:>10.0f}"
+                row += "".join(f" {'-' if counts[name] is None else counts[name]:>12}" for name in COUNTED)
+                print(row)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    commands = parser.add_subparsers(dest="command", required=True)
+
+    relations = commands.add_parser("relations", help="SU_MUL relations against dimension vectors")
+    relations.add_argument("--cxx", default=os.environ.get("CXX", "g++"))
+    relations.add_argument("--relations", type=int, nargs="+", default=[100, 1000, 10000])
+    relations.add_argument("--repeats", type=int, default=3)
+    relations.set_defaults(run=relations_main)
+
+    suite = commands.add_parser("suite", help="cost of units, relations and expressions")
+    suite.add_argument("--cxx", nargs="+", default=["g++", "clang++"])
+    suite.add_argument("--units", type=int, default=300)
+    suite.add_argument("--relations", type=int, default=900)
+    suite.add_argument("--expressions", type=int, nargs="+", default=[100, 1000, 10000])
+    suite.add_argument("--repeats", type=int, default=3)
+    suite.set_defaults(run=suite_main)
+
+    args = parser.parse_args()
+    args.run(args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -1,4 +1,33 @@
-#include "units.hpp"
+#include <algorithm>
+#include <cmath>
+#include <array>
+#include <filesystem>
+#include <list>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#if __has_include(<fmt/format.h>)
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+#endif
+#include "units_atomic.hpp"
+#include "units_bulk.hpp"
+#include "units_dim.hpp"
+#include "units_expr.hpp"
+#include "units_file.hpp"
+#include "units_format.hpp"
+#include "units_histogram.hpp"
+#include "units_id.hpp"
+#include "units_log.hpp"
+#include "units_numeric.hpp"
+#include "units_parallel.hpp"
+#include "units_point.hpp"
+#include "units_sketch.hpp"
 
 SU_DURATION_UNIT(second_t, "s")
 SU_UNIT(hz_t, "Hz")
@@ -8,6 +37,14 @@ SU_UNIT(watt_t, "W")
 SU_INV(second_t, hz_t)
 SU_MUL(second_t, watt_t, joule_t)
 
+// Time, length, mass
+SU_DIM_DURATION_UNIT(dim_second_t, "s", 1)
+SU_DIM_UNIT(metre_t, "m", 0, 1)
+SU_DIM_UNIT(kilogram_t, "kg", 0, 0, 1)
+SU_DIM_UNIT(newton_t, "N", -2, 1, 1)
+SU_DIM_UNIT(dim_joule_t, "J", -2, 2, 1)
+SU_DIM_UNIT(dim_watt_t, "W", -3, 2, 1)
+
 template <typename Rep, typename Scale = std::ratio<1>>
 using second = su::unit<second_t, Rep, Scale>;
 
@@ -20,8 +57,295 @@ using watt = su::unit<watt_t, Rep, Scale>;
 template <typename Rep, typename Scale = std::ratio<1>>
 using joule = su::unit<joule_t, Rep, Scale>;
 
+template <typename U>
+bool formats_like_ostream(const U& u) {
+    std::ostringstream s;
+    s << u;
+    char buffer[64];
+    auto [end, ec] = su::to_chars(buffer, buffer + sizeof(buffer), u);
+    return ec == std::errc() && std::string_view(buffer, end) == s.str();
+}
+
+template <typename U>
+bool parses_as(std::string_view text, U expected, std::size_t consumed) {
+    U u{};
+    auto r = su::from_chars(text.data(), text.data() + text.size(), u);
+    return r.ec == su::parse_errc::ok && r.ptr == text.data() + consumed && u.count() == expected.count();
+}
+
+template <typename U>
+bool fails_with(std::string_view text, su::parse_errc ec, std::size_t at) {
+    U u{};
+    auto r = su::from_chars(text.data(), text.data() + text.size(), u);
+    return r.ec == ec && r.ptr == text.data() + at;
+}
+
+// The spec parsed from text, which must end with '}', or nullopt if it is rejected
+template <typename Rep>
+constexpr std::optional<su::detail::format_spec> parsed_spec(std::string_view text) {
+    su::detail::format_spec spec;
+    const char* first = text.data();
+    if (!spec.parse<Rep>(first, text.data() + text.size()) || *first != '}') {
+        return std::nullopt;
+    }
+    return spec;
+}
+
+constexpr bool same_spec(std::optional<su::detail::format_spec> spec, char fill, char align, int width, int precision, char type) {
+    return spec && spec->fill == fill && spec->align == align && spec->width == width && spec->precision == precision && spec->type == type;
+}
+
+static_assert(same_spec(parsed_spec<double>("}"), ' ', '\0', 0, -1, '\0'));
+static_assert(same_spec(parsed_spec<double>("*^10.3f}"), '*', '^', 10, 3, 'f'));
+static_assert(same_spec(parsed_spec<double>("<8e}"), ' ', '<', 8, -1, 'e'));
+static_assert(same_spec(parsed_spec<double>(".700a}"), ' ', '\0', 0, 700, 'a'));
+static_assert(same_spec(parsed_spec<int>(">>5d}"), '>', '>', 5, -1, 'd'));
+static_assert(!parsed_spec<double>(".701f}") && !parsed_spec<double>(".f}") && !parsed_spec<double>("x}"));
+static_assert(!parsed_spec<int>(".2}") && !parsed_spec<int>("f}") && !parsed_spec<double>("9999999}"));
+
+// text padded by spec, which is counted in code points
+constexpr std::string padded(std::string_view text, std::string_view spec_text) {
+    std::string out;
+    parsed_spec<double>(spec_text)->pad(text.data(), text.data() + text.size(), std::back_inserter(out));
+    return out;
+}
+
+static_assert(padded("3μW", "6}") == "   3μW" && padded("3μW", "*<6}") == "3μW***" && padded("3μW", "^7}") == "  3μW  ");
+static_assert(padded("3μW", "2}") == "3μW" && padded("2.5kW", "}") == "2.5kW");
+
+template <typename To, typename From, std::size_t N>
+constexpr std::array<To, N> bulk_cast(const std::array<From, N>& in) {
+    std::array<To, N> out{};
+    su::unit_cast(std::span(in), std::span(out));
+    return out;
+}
+
+template <typename To, typename From, std::size_t N>
+bool bulk_matches_scalar(const std::array<From, N>& in) {
+    std::array<To, N> out{};
+    su::unit_cast(std::span(in), std::span(out));
+    for (std::size_t i = 0; i < N; ++i) {
+        if (out[i].count() != su::unit_cast<To>(in[i]).count()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename V, typename A, typename B, typename Op>
+bool vector_matches_scalar(const V& result, const A& a, const B& b, Op op) {
+    for (std::size_t i = 0; i < a.size(); ++i) {
+        if (result[i].count() != op(a[i], b[i]).count()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr auto vector_sum() {
+    su::unit_vector<watt_t, int64_t, std::kilo> a{watt<int64_t, std::kilo>(1), watt<int64_t, std::kilo>(2)};
+    su::unit_vector<watt_t, int64_t> b{watt<int64_t>(3), watt<int64_t>(4)};
+    auto c = a + b;
+    return c[0].count() * 10000 + c[1].count();
+}
+
+constexpr auto vector_energy() {
+    su::unit_vector<second_t, int64_t, std::kilo> t(3, second<int64_t, std::kilo>(2));
+    su::unit_vector<watt_t, int64_t, std::milli> p(3, watt<int64_t, std::milli>(5));
+    return (t * p)[2];
+}
+
+constexpr auto lazy_cast_sum() {
+    std::array milliwatts{watt<int64_t, std::milli>(1500), watt<int64_t, std::milli>(2500), watt<int64_t, std::milli>(3000)};
+    double sum = 0;
+    for (auto w : milliwatts | su::views::unit_cast<watt<double>>) {
+        sum += w.count();
+    }
+    return sum;
+}
+
+constexpr auto chunked_cast_sizes() {
+    std::array<watt<int64_t>, 10> watts{};
+    int64_t result = 0;
+    constexpr auto pipeline = su::views::unit_cast<watt<int64_t, std::milli>> | su::views::chunk(4);
+    for (auto chunk : watts | pipeline) {
+        result = result * 10 + int64_t(chunk.size());
+    }
+    return result;
+}
+
+template <typename R, typename V>
+concept can_pipe = requires (R&& r, const V& v) { std::forward<R>(r) | v; };
+
+// Views of temporaries would dangle, so only borrowed ranges are accepted
+static_assert(can_pipe<std::vector<watt<int64_t, std::milli>>&, decltype(su::views::unit_cast<watt<double>>)>);
+static_assert(!can_pipe<std::vector<watt<int64_t, std::milli>>, decltype(su::views::unit_cast<watt<double>>)>);
+static_assert(can_pipe<std::span<watt<int64_t, std::milli>>, decltype(su::views::unit_cast<watt<double>>)>);
+static_assert(!can_pipe<std::vector<int64_t>, decltype(su::views::as_units<watt_t>)>);
+static_assert(!can_pipe<std::vector<watt<int64_t>>, decltype(su::views::chunk(4))>);
+static_assert(!can_pipe<std::vector<watt<int64_t>>, decltype(su::views::unit_cast<watt<double>> | su::views::chunk(4))>);
+
+static_assert(su::type_id<watt<int64_t, std::kilo>> != su::type_id<watt<int64_t>>);
+static_assert(su::type_id<watt<int64_t>> != su::type_id<watt<uint64_t>>);
+static_assert(su::type_id<watt<int64_t>> != su::type_id<watt<int32_t>>);
+static_assert(su::type_id<watt<int64_t>> != su::type_id<watt<double>>);
+static_assert(su::type_id<watt<int64_t>> != su::type_id<joule<int64_t>>);
+static_assert(su::type_id<watt<long>> == su::type_id<watt<long long>>);
+static_assert(su::type_id<su::unit<dim_joule_t, int64_t>> == su::type_id<joule<int64_t>>);
+static_assert(su::type_info_of<joule<float, std::ratio<3600>>> ==
+    su::unit_type_info{su::type_id<joule<float, std::ratio<3600>>>, "J", "[3600]J", su::rep_kind::floating_point, 4, 3600, 1});
+
+// Registers a spread of types, to check that every one is found through the perfect hash
+template <intmax_t... N>
+bool registry_finds_all() {
+    su::type_registry registry;
+    bool added = (registry.add<watt<int32_t, std::ratio<N>>>() && ...) && (registry.add<joule<double, std::ratio<1, N>>>() && ...);
+    bool found = ((registry.find(su::type_id<watt<int32_t, std::ratio<N>>>) == &su::type_info_of<watt<int32_t, std::ratio<N>>>) && ...) &&
+        ((registry.find(su::type_id<joule<double, std::ratio<1, N>>>) == &su::type_info_of<joule<double, std::ratio<1, N>>>) && ...);
+    return added && found && registry.size() == 2 * sizeof...(N) && !registry.find(su::type_id<hz<int32_t>>);
+}
+
+static_assert(std::atomic<joule<int64_t>>::is_always_lock_free && std::atomic<joule<double>>::is_always_lock_free);
+template <typename A, typename U>
+concept can_fetch_add = requires (A& a, U u) { a.fetch_add(u); };
+
+static_assert(can_fetch_add<std::atomic<joule<int64_t>>, joule<int64_t, std::kilo>>);
+static_assert(!can_fetch_add<std::atomic<joule<int64_t, std::kilo>>, joule<int64_t>>);
+static_assert(!can_fetch_add<std::atomic<joule<int64_t>>, watt<int64_t>>);
+
+static_assert(sizeof(su::sharded_counter<joule<int64_t>, 4>) == 4 * 64);
+
+constexpr watt<double> kahan_sum() {
+    su::kahan_accumulator<watt<double>> acc;
+    acc += watt<double>(1e16);
+    for (int i = 0; i < 8; ++i) {
+        acc += watt<double>(1);
+    }
+    return acc.value();
+}
+
+constexpr watt<double> kahan_merged_sum() {
+    su::kahan_accumulator<watt<double>> a;
+    su::kahan_accumulator<watt<double>> b(watt<double>(1e16));
+    for (int i = 0; i < 7; ++i) {
+        a += watt<double>(1);
+        b += watt<double>(1);
+    }
+    // 1e16 + 7 is not a double, so b holds a compensation, and its sum is
+    // larger than a's
+    a += b;
+    return a.value();
+}
+
+constexpr watt<double> neumaier_sum() {
+    su::neumaier_accumulator<watt<double>> a;
+    su::neumaier_accumulator<watt<double>> b(watt<double>(1));
+    a += watt<double, std::kilo>(1);
+    a += watt<double>(1e100);
+    b += watt<double>(-1e100);
+    a += b;
+    return a.value();
+}
+
+static_assert(kahan_sum() == watt<double>(1e16 + 8) && kahan_merged_sum() == watt<double>(1e16 + 14));
+static_assert(neumaier_sum() == watt<double>(1001));
+
+static_assert(std::is_same_v<su::accumulator_rep_t<int32_t>, int64_t> && std::is_same_v<su::accumulator_rep_t<uint16_t>, uint64_t>);
+static_assert(std::is_same_v<su::accumulator_rep_t<int32_t, (uint64_t(1) << 32) - 1>, int64_t>);
+static_assert(std::is_same_v<su::accumulator_rep_t<int32_t, uint64_t(1) << 32>, int64_t> && sizeof(su::accumulator_rep_t<int32_t, (uint64_t(1) << 32) + 1>) == 16);
+static_assert(std::is_same_v<su::accumulator_rep_t<int64_t, 1>, int64_t> && sizeof(su::accumulator_rep_t<int64_t, 2>) == 16);
+static_assert(std::is_same_v<su::accumulator_rep_t<uint32_t, uint64_t(1) << 32>, uint64_t>);
+
+// Each value lies within its bucket, and the buckets tile the values
+template <int Bits>
+constexpr bool buckets_tile(std::uint64_t first, std::uint64_t last) {
+    for (std::uint64_t v = first; v <= last; ++v) {
+        std::size_t b = su::detail::histogram_bucket<Bits>(v);
+        if (su::detail::histogram_lowest<Bits>(b) > v || su::detail::histogram_highest<Bits>(b) < v ||
+            (b > 0 && su::detail::histogram_highest<Bits>(b - 1) + 1 != su::detail::histogram_lowest<Bits>(b))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(buckets_tile<7>(0, 5000) && buckets_tile<3>((uint64_t(1) << 40) - 100, (uint64_t(1) << 40) + 100));
+static_assert(buckets_tile<7>(~uint64_t(0) - 10, ~uint64_t(0) - 1));
+static_assert(su::histogram<second<int64_t, std::nano>>::bucket_count == 7424);
+static_assert(su::detail::histogram_highest<7>(su::detail::histogram_bucket<7>(1'000'000)) - 1'000'000 < 1'000'000 / 128);
+
+constexpr std::array<watt<int32_t, std::milli>, 3> large_readings{
+    watt<int32_t, std::milli>(2'000'000'000), watt<int32_t, std::milli>(2'000'000'000), watt<int32_t, std::milli>(-500)};
+static_assert(su::accumulate(large_readings) == watt<int64_t, std::milli>(3'999'999'500));
+static_assert(su::reduce<watt<int64_t>>(large_readings) == watt<int64_t>(3'999'999));
+static_assert(su::reduce<watt<double, std::kilo>>(large_readings) == watt<double, std::kilo>(3'999.9995));
+
+// A sum too large for the result rep throws, so it is not a constant
+// expression, with or without NDEBUG
+template <typename Result>
+constexpr bool reduces_large_readings = requires { typename std::integral_constant<int, (su::reduce<Result>(large_readings), 0)>; };
+
+static_assert(reduces_large_readings<watt<int32_t>> && reduces_large_readings<watt<uint32_t, std::milli>>);
+static_assert(!reduces_large_readings<watt<int32_t, std::milli>> && !reduces_large_readings<watt<int16_t>>);
+
+static_assert(std::is_same_v<su::square_tag_t<watt_t>, su::squared_t<watt_t>>);
+static_assert(std::is_same_v<su::square_tag_t<dim_watt_t>, su::dim_t<-6, 4, 2>>);
+static_assert(su::unit_suffix<su::squared_t<watt_t>> == "W²");
+static_assert(su::unit_suffix<su::squared_t<watt_t>, std::mega> == "M(W²)");
+
+constexpr std::array<watt<int32_t, std::milli>, 4> small_readings{
+    watt<int32_t, std::milli>(1), watt<int32_t, std::milli>(2), watt<int32_t, std::milli>(3), watt<int32_t, std::milli>(6)};
+constexpr auto readings_statistics = su::statistics(small_readings);
+static_assert(std::is_same_v<decltype(readings_statistics.variance()), su::unit<su::squared_t<watt_t>, double, std::micro>>);
+static_assert(readings_statistics.count() == 4 && readings_statistics.mean() == watt<double, std::milli>(3) &&
+    readings_statistics.variance().count() == 3.5 && readings_statistics.sample_variance().count() == 14.0 / 3 &&
+    readings_statistics.min() == watt<int32_t, std::milli>(1) && readings_statistics.max() == watt<int32_t, std::milli>(6));
+
+struct cycle_clock {};
+struct ptp_clock { using chrono_clock = std::chrono::system_clock; };
+
+using ptp_point = su::point<ptp_clock, second<int64_t, std::nano>>;
+using cycle_point = su::point<cycle_clock, second<int64_t, std::nano>>;
+
+template <typename A, typename B>
+concept can_subtract = requires (A a, B b) { a - b; };
+
+static_assert(sizeof(ptp_point) == sizeof(int64_t) && std::is_trivially_copyable_v<ptp_point>);
+static_assert(std::is_same_v<decltype(ptp_point() - ptp_point()), second<int64_t, std::nano>>);
+static_assert(ptp_point(second<int64_t, std::nano>(1500)) - ptp_point(second<int64_t, std::nano>(500)) == second<int64_t, std::micro>(1));
+static_assert(std::is_same_v<decltype(ptp_point() + second<int64_t, std::milli>(1)), ptp_point>);
+static_assert(std::is_same_v<decltype(ptp_point() - second<double>(1)), su::point<ptp_clock, second<double, std::nano>>>);
+static_assert((second<int64_t>(2) + ptp_point()).time_since_epoch() == second<int64_t, std::nano>(2'000'000'000));
+static_assert(su::point<ptp_clock, second<int64_t>>(second<int64_t>(3)) == ptp_point(second<int64_t, std::nano>(3'000'000'000)));
+static_assert(ptp_point(second<int64_t, std::nano>(1)) > su::point<ptp_clock, second<int64_t>>());
+static_assert(su::point_cast<second<int64_t, std::micro>>(ptp_point(second<int64_t, std::nano>(2999))).time_since_epoch().count() == 2);
+static_assert(!can_subtract<ptp_point, cycle_point> && !can_subtract<ptp_point, second<int64_t, std::nano>::rep>);
+static_assert(std::is_convertible_v<su::point<ptp_clock, second<int64_t>>, ptp_point>);
+static_assert(!std::is_convertible_v<ptp_point, su::point<ptp_clock, second<int64_t>>>);
+
+// Chrono time points of the clock's chrono clock convert as their durations do
+static_assert(ptp_point(std::chrono::sys_time<std::chrono::milliseconds>(std::chrono::milliseconds(5))).time_since_epoch() ==
+    second<int64_t, std::milli>(5));
+static_assert(std::chrono::sys_time<std::chrono::microseconds>(ptp_point(second<int64_t, std::nano>(7000))).time_since_epoch() ==
+    std::chrono::microseconds(7));
+static_assert(!std::is_convertible_v<std::chrono::sys_time<std::chrono::nanoseconds>, su::point<ptp_clock, second<int64_t, std::micro>>>);
+static_assert(!std::is_convertible_v<std::chrono::steady_clock::time_point, ptp_point>);
+static_assert(!std::is_convertible_v<cycle_point, std::chrono::sys_time<std::chrono::nanoseconds>>);
+static_assert(std::is_same_v<su::chrono_clock_t<std::chrono::steady_clock>, std::chrono::steady_clock>);
+static_assert(std::chrono::steady_clock::time_point(su::point<std::chrono::steady_clock, second<int64_t, std::nano>>(second<int64_t>(1))) ==
+    std::chrono::steady_clock::time_point(std::chrono::seconds(1)));
+
 int main() {
+    static_assert(std::is_trivially_copyable_v<second<int64_t>> && std::is_trivially_copyable_v<second<double, std::milli>>);
+    static_assert(std::is_trivially_default_constructible_v<second<int64_t>>);
+
     static_assert(second<int64_t>(5).count() == 5);
+    static_assert((second<int64_t>(5) += second<int64_t>(2)) == second<int64_t>(7));
+    static_assert((second<int64_t>(5) -= second<int64_t>(2)) == second<int64_t>(3));
+    static_assert((second<int64_t>(5) *= 3) == second<int64_t>(15));
+    static_assert((second<int64_t>(15) /= 3) == second<int64_t>(5));
+    static_assert((second<int64_t>(5) %= second<int64_t>(3)) == second<int64_t>(2));
+    static_assert((second<int64_t>(5) %= 4) == second<int64_t>(1));
     static_assert(second<int64_t>(5).value() == 5);
 
     static_assert(second<int64_t, std::kilo>(5) == second<int64_t>(5000));
@@ -62,4 +386,590 @@ int main() {
     static_assert(second<int64_t>(5) == second<int64_t>(std::chrono::seconds(5)));
     static_assert(std::chrono::seconds(second<int64_t, std::kilo>(5)) == std::chrono::seconds(5000));
     static_assert(second<int64_t, std::kilo>(5) == second<int64_t>(std::chrono::seconds(5000)));
-}
\ No newline at end of file
+
+    static_assert(bulk_cast<watt<int64_t>>(std::array{watt<int64_t, std::kilo>(1), watt<int64_t, std::kilo>(2)})[1] == watt<int64_t>(2000));
+    static_assert(bulk_cast<watt<double, std::kilo>>(std::array{watt<int32_t, std::milli>(1500)})[0].count() == 0.0015);
+
+    using third_second = second<int64_t, std::ratio<1, 3>>;
+    static_assert(su::unit_cast<second<int64_t, std::milli>>(third_second(15'000'000'000'000'000)).count() == 5'000'000'000'000'000'000);
+    static_assert(su::unit_cast<second<int64_t, std::milli>>(third_second(-15'000'000'000'000'001)).count() == -5'000'000'000'000'000'333);
+    static_assert(su::unit_cast<second<int64_t, std::milli>>(third_second(7)).count() == 2333);
+    static_assert(su::unit_cast<second<int64_t, std::ratio<999'999'937>>>(second<int64_t, std::ratio<1'000'000'007>>(9'000'000'000)).count() == 9'000'000'630);
+
+    static_assert(su::unit_cast<watt<double, std::milli>>(watt<double>(1.5), su::fast_math).count() == 1500);
+    static_assert(su::unit_cast<watt<double, std::ratio<1, 1024>>>(watt<double>(3), su::fast_math).count() == 3072);
+    static_assert(su::unit_cast<watt<int64_t>>(watt<int64_t, std::milli>(2500), su::fast_math).count() == 2);
+    static_assert(su::unit_cast<watt<double, std::kilo>>(watt<double>(1), su::strict) == su::unit_cast<watt<double, std::kilo>>(watt<double>(1)));
+
+    {
+        using su::expr::lazy;
+        constexpr auto e = (lazy(watt<double, std::kilo>(2)) + watt<double>(500)) * second<double>(4);
+        static_assert(std::is_same_v<decltype(su::expr::eval(e)), joule<double>>);
+        static_assert(su::expr::eval(e) == joule<double>(10'000));
+        static_assert(su::expr::eval<joule<double, std::kilo>>(e).count() == 10);
+        constexpr joule<double, std::mega> megajoules = e;
+        static_assert(megajoules.count() == 0.01);
+        constexpr double ratio = e / joule<double, std::kilo>(5);
+        static_assert(ratio == 2);
+        static_assert(su::expr::eval(lazy(watt<double>(3)) * 2.0 - watt<double, std::milli>(500)) == watt<double>(5.5));
+        static_assert(su::expr::eval(lazy(second<int64_t, std::kilo>(3)) * hz<int64_t>(2)) == 6000);
+
+        // Integer expressions convert implicitly only where a unit of their
+        // scale would, and eval<To> rounds the whole result rather than each leaf
+        constexpr auto milliwatts = lazy(watt<int, std::milli>(1500)) + watt<int, std::milli>(1500);
+        static_assert(!std::is_convertible_v<decltype(milliwatts), watt<int>>);
+        static_assert(std::is_convertible_v<decltype(milliwatts), watt<int, std::micro>>);
+        static_assert(std::is_convertible_v<decltype(milliwatts), watt<double>>);
+        static_assert(su::expr::eval<watt<int>>(milliwatts) == watt<int>(3));
+        static_assert(!std::is_convertible_v<decltype(lazy(second<int64_t, std::milli>(1500)) * hz<int64_t>(2)), int64_t>);
+    }
+
+    static_assert(std::is_same_v<su::dim_t<1, 0, 0>, su::dim<1>>);
+    static_assert(std::is_same_v<su::dim_t<0, 0>, void>);
+    static_assert(std::is_same_v<su::ops::div<su::ops::div<dim_joule_t, dim_second_t>::type, dim_second_t>::type, su::dim<-4, 2, 1>>);
+    static_assert(su::unit<newton_t, int64_t>(3) * su::unit<metre_t, int64_t, std::kilo>(2) == su::unit<dim_joule_t, int64_t>(6000));
+    static_assert(su::unit<dim_joule_t, int64_t>(12) / su::unit<dim_second_t, int64_t>(4) == su::unit<dim_watt_t, int64_t>(3));
+    static_assert(su::unit<dim_watt_t, int64_t>(3) / su::unit<dim_watt_t, int64_t, std::milli>(1500) == 2);
+    static_assert(std::is_same_v<su::ops::div<void, dim_second_t>::type, su::dim<-1>>);
+    static_assert(std::chrono::seconds(su::unit<dim_second_t, int64_t>(5)) == std::chrono::seconds(5));
+
+    static_assert(su::unit_suffix<watt_t, std::kilo> == "kW");
+    static_assert(su::unit_suffix<second_t, std::micro> == "μs");
+    static_assert(su::unit_suffix<joule_t, std::ratio<-3, 2>> == "[-3/2]J");
+    static_assert(su::unit_suffix<hz_t, std::ratio<60>> == "[60]Hz");
+    static_assert(su::unit_suffix<newton_t> == "N");
+
+    static_assert(su::unit_suffix<su::dim<-2, 1>> == "m/s²");
+    static_assert(su::unit_suffix<su::dim<-2, 1>, std::kilo> == "k(m/s²)");
+    static_assert(su::unit_suffix<su::dim<-4, 2, 1>> == "m²·kg/s⁴");
+    static_assert(su::unit_suffix<su::dim<-2, -1, 1>> == "kg/(s²·m)");
+    static_assert(su::unit_suffix<su::dim<-1, 0, -12>> == "s⁻¹·kg⁻¹²");
+    static_assert(su::unit_suffix<newton_t, std::kilo> == "kN");
+    static_assert(su::unit_suffix<void> == "" && su::unit_suffix<void, std::kilo> == "[1000]");
+    static_assert(!su::has_symbol<su::dim<0, 0, 0, 1>> && !su::has_symbol<su::dim<0, 0, 0, 2>>);
+    static_assert(std::is_same_v<decltype(su::unit_symbol<su::dim<2>>::value), const char* const>);
+
+    static_assert(vector_sum() == 10032004);
+    static_assert(vector_energy() == joule<int64_t>(10));
+
+    std::array<watt<int32_t, std::milli>, 37> milliwatts{};
+    std::array<watt<double>, 37> watts{};
+    for (std::size_t i = 0; i < milliwatts.size(); ++i) {
+        milliwatts[i] = watt<int32_t, std::milli>(int32_t(i * 7919) - 100'000);
+        watts[i] = watt<double>(double(i) * 0.37 - 5);
+    }
+
+    if (!bulk_matches_scalar<watt<double, std::kilo>>(milliwatts) ||
+        !bulk_matches_scalar<watt<int32_t>>(milliwatts) ||
+        !bulk_matches_scalar<watt<int32_t, std::micro>>(milliwatts) ||
+        !bulk_matches_scalar<watt<float, std::milli>>(watts) ||
+        !bulk_matches_scalar<watt<double, std::milli>>(watts)) {
+        return 1;
+    }
+
+    static_assert(std::ranges::view<su::unit_span<watt_t, double>>);
+    static_assert(std::is_same_v<decltype(su::as_units<watt_t>(std::span<const int64_t>())), std::span<const watt<int64_t>>>);
+
+    double raw_watts[] = {1.5, 2.5, 3.5};
+    auto watts_view = su::as_units<watt_t, std::kilo>(std::span(raw_watts));
+    watts_view[1] = watt<double, std::kilo>(4);
+    if (static_cast<void*>(watts_view.data()) != raw_watts || raw_watts[1] != 4 || watts_view[2] != watt<double>(3500)) {
+        return 1;
+    }
+
+    std::vector<int64_t> raw_seconds = {1, 2, 3};
+    auto seconds_view = raw_seconds | su::views::as_units<second_t, std::milli>;
+    if (seconds_view.size() != 3 || seconds_view[0] != second<int64_t, std::milli>(1) || su::as_units<second_t>(raw_seconds.data(), 2).size() != 2) {
+        return 1;
+    }
+
+    static_assert(lazy_cast_sum() == 7);
+    static_assert(chunked_cast_sizes() == 442);
+    static_assert(std::ranges::random_access_range<su::unit_cast_view<watt<double>, watt<int64_t>>>);
+    static_assert(std::ranges::borrowed_range<su::unit_cast_view<watt<double>, watt<int64_t>>>);
+
+    auto lazy = milliwatts | su::views::unit_cast<watt<double, std::kilo>>;
+    std::array<watt<double, std::kilo>, 37> converted{};
+    lazy.convert(converted);
+    if (lazy.source().data() != milliwatts.data() || lazy[5] != converted[5] || lazy.end() - lazy.begin() != 37) {
+        return 1;
+    }
+
+    su::unit_vector<watt_t, double, std::kilo> kilowatts(37);
+    su::unit_vector<watt_t, double> watts_vec(37);
+    su::unit_vector<watt_t, int32_t> int_watts(37);
+    su::unit_vector<second_t, double> seconds_vec(37);
+    for (std::size_t i = 0; i < kilowatts.size(); ++i) {
+        kilowatts[i] = watt<double, std::kilo>(double(i) * 0.37 - 5);
+        watts_vec[i] = watt<double>(double(i) * 13.1);
+        int_watts[i] = watt<int32_t>(int32_t(i * 7919) - 100'000);
+        seconds_vec[i] = second<double>(double(i) + 0.5);
+    }
+
+    if (reinterpret_cast<std::uintptr_t>(kilowatts.raw().data()) % 64 != 0 ||
+        !vector_matches_scalar(kilowatts + watts_vec, kilowatts, watts_vec, std::plus<>()) ||
+        !vector_matches_scalar(watts_vec - kilowatts, watts_vec, kilowatts, std::minus<>()) ||
+        !vector_matches_scalar(int_watts - int_watts, int_watts, int_watts, std::minus<>()) ||
+        !vector_matches_scalar(kilowatts * seconds_vec, kilowatts, seconds_vec, std::multiplies<>()) ||
+        !vector_matches_scalar(watts_vec * 3.0, watts_vec, std::array<double, 37>{}, [](auto a, auto) { return a * 3.0; }) ||
+        !vector_matches_scalar(int_watts * 3, int_watts, int_watts, [](auto a, auto) { return a * 3; }) ||
+        !vector_matches_scalar(watts_vec / 7.0, watts_vec, watts_vec, [](auto a, auto) { return a / 7.0; })) {
+        return 1;
+    }
+
+    char buffer[16];
+    auto [end, ec] = su::to_chars(buffer, buffer + sizeof(buffer), watt<double, std::kilo>(2.5), std::chars_format::fixed, 3);
+    if (std::string_view(buffer, end) != "2.500kW" || ec != std::errc() ||
+        su::to_chars(buffer, buffer + 3, watt<int64_t, std::kilo>(25)).ec != std::errc::value_too_large ||
+        su::to_chars(buffer, buffer + 2, watt<int64_t, std::kilo>(25)).ec != std::errc::value_too_large ||
+        !formats_like_ostream(watt<int64_t, std::kilo>(-25)) ||
+        !formats_like_ostream(second<double, std::micro>(0.125)) ||
+        !formats_like_ostream(joule<int32_t, std::ratio<7, 3>>(4)) ||
+        !formats_like_ostream(su::unit<newton_t, int64_t, std::mega>(9)) ||
+        !formats_like_ostream(su::unit<su::dim<-2, 1>, double, std::milli>(9.5)) ||
+        !formats_like_ostream(su::quantity<int64_t, std::milli>(3))) {
+        return 1;
+    }
+#if defined(FMT_VERSION)
+    if (fmt::format("{:>8.2f}", watt<double, std::kilo>(2.5)) != "  2.50kW" || fmt::format("{}", watt<double>(0.5)) != "0.5W" ||
+        fmt::format("{:*<6}", watt<int>(5)) != "5W****" || fmt::format("{:^7d}", watt<int, std::micro>(3)) != "  3μW  " ||
+        fmt::format("{:.3e}", watt<double>(1250)) != "1.250e+03W" || fmt::format("{:g}", watt<double>(1e-5)) != "1e-05W" ||
+        fmt::format("{:.700f}", watt<double>(std::numeric_limits<double>::max())).size() != 309 + 1 + 700 + 1 ||
+        fmt::format("{:.700f}", watt<long double, std::milli>(std::numeric_limits<long double>::lowest())).size() !=
+            1 + std::numeric_limits<long double>::max_exponent10 + 1 + 1 + 700 + 2) {
+        return 1;
+    }
+    // Precision and floating point types for an integer rep, an unknown type
+    for (auto bad : {"{:.2}", "{:f}", "{:x}"}) {
+        try {
+            (void)fmt::format(fmt::runtime(bad), watt<int>(1));
+            return 1;
+        } catch (const fmt::format_error&) {
+        }
+    }
+    // Rejected by the parser rather than when the text does not fit
+    try {
+        (void)fmt::format(fmt::runtime("{:.1000f}"), watt<double>(1));
+        return 1;
+    } catch (const fmt::format_error&) {
+    }
+#endif
+
+    if (!parses_as("2.5 kW", watt<int64_t, std::milli>(2'500'000), 6) ||
+        !parses_as("500mW,", watt<double>(0.5), 5) ||
+        !parses_as("250 uW", watt<int64_t, std::nano>(250'000), 6) ||
+        !parses_as("250μW", watt<int64_t, std::nano>(250'000), 6) ||
+        !parses_as("-1.5e3 J", joule<int32_t>(-1500), 8) ||
+        !parses_as("4[3/2]J", joule<int32_t, std::milli>(6000), 7) ||
+        !parses_as("100000000000000000000000 aW", watt<int64_t>(100'000), 27) ||
+        !parses_as("3 mm", su::unit<metre_t, int32_t, std::milli>(3), 4) ||
+        !parses_as("1 EW", watt<double, std::atto>(1e36), 4) ||
+        !parses_as("9.8 k(m/s²)", su::unit<su::dim<-2, 1>, double>(9800), 12) ||
+        !parses_as("9.8m/s²", su::unit<su::dim<-2, 1>, double>(9.8), 8) ||
+        !fails_with<watt<int64_t>>("500 mW", su::parse_errc::inexact, 0) ||
+        !fails_with<watt<int64_t>>("W", su::parse_errc::invalid_number, 0) ||
+        !fails_with<watt<int64_t>>("5", su::parse_errc::missing_symbol, 1) ||
+        !fails_with<watt<int64_t>>("5 Wh", su::parse_errc::wrong_symbol, 2) ||
+        !fails_with<watt<int64_t>>("5 J", su::parse_errc::wrong_symbol, 2) ||
+        !fails_with<watt<int64_t>>("5 xW", su::parse_errc::unknown_prefix, 2) ||
+        !fails_with<watt<int8_t>>("200 W", su::parse_errc::out_of_range, 0) ||
+        !fails_with<watt<uint32_t>>("-2 W", su::parse_errc::out_of_range, 0) ||
+        !fails_with<watt<int64_t>>("9e30 W", su::parse_errc::out_of_range, 0) ||
+        !parses_as("-9223372036854775808 W", watt<int64_t>(INT64_MIN), 22) ||
+        !parses_as("-9223372036854775.808 kW", watt<int64_t>(INT64_MIN), 24) ||
+        !parses_as("9223372036854775807 W", watt<int64_t>(INT64_MAX), 21) ||
+        !parses_as("18446744073709551615 W", watt<uint64_t>(UINT64_MAX), 22) ||
+        !parses_as("-128 W", watt<int8_t>(-128), 6) ||
+        !parses_as("-0 W", watt<uint32_t>(0), 4) ||
+        !fails_with<watt<int64_t>>("-9223372036854775809 W", su::parse_errc::out_of_range, 0) ||
+        !fails_with<watt<int64_t>>("9223372036854775808 W", su::parse_errc::out_of_range, 0) ||
+        !fails_with<watt<int8_t>>("-129 W", su::parse_errc::out_of_range, 0)) {
+        return 1;
+    }
+
+    std::string_view lines = "1 W\n  2 kW \r\n\n3mW\n4 W\n5 X\n";
+    std::array<watt<int64_t, std::milli>, 3> parsed{};
+    auto full = su::from_chars(lines.data(), lines.data() + lines.size(), std::span(parsed));
+    if (full != su::bulk_from_chars_result{lines.data() + 18, su::parse_errc::ok, 3} ||
+        parsed[0].count() != 1000 || parsed[1].count() != 2'000'000 || parsed[2].count() != 3) {
+        return 1;
+    }
+    auto error = su::from_chars(full.ptr, lines.data() + lines.size(), std::span(parsed));
+    if (error != su::bulk_from_chars_result{lines.data() + 24, su::parse_errc::wrong_symbol, 1} || parsed[0].count() != 4000) {
+        return 1;
+    }
+
+    if (!registry_finds_all<1, 2, 3, 5, 7, 10, 60, 100, 1000, 3600, 86400, 1'000'000, 1'000'000'000>()) {
+        return 1;
+    }
+    su::type_registry registry;
+    su::unit_type_info clash = su::type_info_of<watt<int32_t>>;
+    clash.symbol = "X";
+    if (!registry.add<watt<int32_t>>() || !registry.add<watt<int32_t>>() || registry.add(clash) || registry.size() != 1 ||
+        registry.find(clash.id)->symbol != "W") {
+        return 1;
+    }
+
+    std::thread writer([] { su::binlog::write(joule<double, std::kilo>(2.5)); });
+    writer.join();
+    su::binlog::attach();
+    su::binlog::attach();
+    su::binlog::write(second<int64_t, std::nano>(-42));
+    su::binlog::write(su::unit<su::dim<-2, 1>, float>(9.75f));
+    std::vector<std::string> logged;
+    auto decoded = su::binlog::drain([&](const su::binlog::record& r) {
+        char text[64];
+        auto [end, ec] = su::binlog::decode(r, text, text + sizeof(text));
+        logged.emplace_back(text, ec == std::errc() ? end : text);
+    });
+    std::sort(logged.begin(), logged.end());
+    if (decoded != 3 || logged != std::vector<std::string>{"-42ns", "2.5kJ", "9.75m/s²"} ||
+        su::binlog::drain([](const su::binlog::record&) {}) != 0 || su::binlog::dropped() != 0) {
+        return 1;
+    }
+    // A drainer that checks for drops and logs its own progress, from a
+    // thread whose first write is inside the callback
+    su::binlog::write(second<int64_t, std::nano>(7));
+    std::size_t drained_in_thread = 0;
+    std::thread drainer([&] {
+        drained_in_thread = su::binlog::drain([](const su::binlog::record&) {
+            if (su::binlog::dropped() == 0) {
+                su::binlog::write(second<int64_t, std::nano>(8));
+            }
+        });
+    });
+    drainer.join();
+    if (drained_in_thread != 1 || su::binlog::drain([](const su::binlog::record&) {}) != 1) {
+        return 1;
+    }
+    char text[8];
+    if (su::binlog::decode({0, 0}, text, text + sizeof(text)).ec != std::errc::invalid_argument ||
+        su::binlog::decode({su::type_id<second<int64_t, std::nano>>, 123456789}, text, text + 4).ec !=
+            std::errc::value_too_large) {
+        return 1;
+    }
+
+    std::vector<second<int64_t, std::milli>> times{second<int64_t, std::milli>(1), second<int64_t, std::milli>(-2), second<int64_t, std::milli>(3)};
+    std::vector<watt<double, std::kilo>> power{watt<double, std::kilo>(1.5), watt<double, std::kilo>(0.25)};
+    const su::series_column columns[] = {su::make_series_column("time", std::span(times)), su::make_series_column("power", std::span(power))};
+    // A name of its own for each run, so that concurrent runs do not share the file
+    auto path = std::filesystem::temp_directory_path() / ("su_test_series_" + std::to_string(std::random_device()()) + ".bin");
+    if (su::write_series(path, columns) != su::file_errc::ok ||
+        su::write_series(path, std::span(columns).first(1)) != su::file_errc::ok ||
+        su::write_series(path, columns) != su::file_errc::ok) {
+        return 1;
+    }
+    su::series_file file;
+    if (file.open(path) != su::file_errc::ok || file.columns().size() != 2 || file.columns()[1].symbol != "W") {
+        return 1;
+    }
+    auto time_view = file.view<second<int64_t, std::milli>>("time");
+    auto power_view = file.view<watt<double, std::kilo>>("power");
+    if (time_view.ec != su::file_errc::ok || !std::equal(times.begin(), times.end(), time_view.values.begin(), time_view.values.end()) ||
+        reinterpret_cast<std::uintptr_t>(time_view.values.data()) % su::series_alignment != 0 ||
+        power_view.ec != su::file_errc::ok || power_view.values.size() != 2 || power_view.values[1] != power[1] ||
+        file.view<second<int64_t>>("time").ec != su::file_errc::wrong_scale ||
+        file.view<second<int32_t, std::milli>>("time").ec != su::file_errc::wrong_rep ||
+        file.view<joule<int64_t, std::milli>>("time").ec != su::file_errc::wrong_symbol ||
+        file.view<second<int64_t, std::milli>>("energy").ec != su::file_errc::no_such_column) {
+        return 1;
+    }
+    std::array<second<int64_t, std::micro>, 3> micros{};
+    std::array<watt<double>, 2> read_watts{};
+    std::array<second<int64_t>, 3> seconds{};
+    std::array<second<int64_t, std::micro>, 2> short_micros{};
+    if (file.read("time", std::span(micros)) != su::series_read_result{3, su::file_errc::ok} || micros[1].count() != -2000 ||
+        file.read("power", std::span(read_watts)) != su::series_read_result{2, su::file_errc::ok} ||
+        read_watts[0] != su::unit_cast<watt<double>>(power[0]) || read_watts[1] != su::unit_cast<watt<double>>(power[1]) ||
+        file.read("time", std::span(seconds)).ec != su::file_errc::wrong_scale ||
+        file.read("time", std::span(short_micros)).ec != su::file_errc::buffer_too_small) {
+        return 1;
+    }
+    // Unmapped before the file is rewritten under it
+    file.close();
+    std::vector<second<int64_t>> huge{second<int64_t>(INT64_MAX / 100)};
+    const su::series_column huge_column[] = {su::make_series_column("t", std::span(huge))};
+    su::series_file huge_file;
+    if (su::write_series(path, huge_column) != su::file_errc::ok || huge_file.open(path) != su::file_errc::ok ||
+        huge_file.read("t", std::span(micros)).ec != su::file_errc::out_of_range) {
+        return 1;
+    }
+    huge_file.close();
+
+    // Cuts the last column short, then breaks the magic
+    std::filesystem::resize_file(path, 64 + 128 + 4);
+    if (su::series_file().open(path) != su::file_errc::corrupt) {
+        return 1;
+    }
+    std::filesystem::resize_file(path, 8);
+    if (su::series_file().open(path) != su::file_errc::not_a_series_file ||
+        su::series_file().open(path.string() + ".missing") != su::file_errc::io_error) {
+        return 1;
+    }
+    std::filesystem::remove(path);
+
+    std::atomic<joule<int64_t>> energy(joule<int64_t>(5));
+    std::atomic<joule<double, std::kilo>> energy_kj;
+    if (energy.fetch_add(joule<int64_t, std::kilo>(2)) != joule<int64_t>(5) || energy.load() != joule<int64_t>(2005) ||
+        energy.fetch_sub(joule<int64_t>(5)) != joule<int64_t>(2005) || (energy -= joule<int64_t>(1000)) != joule<int64_t>(1000) ||
+        (energy_kj += joule<int64_t>(1500)) != joule<double, std::kilo>(1.5) ||
+        energy_kj.fetch_sub(joule<double, std::kilo>(0.5)) != joule<double, std::kilo>(1.5)) {
+        return 1;
+    }
+    joule<int64_t> expected(1);
+    if (energy.compare_exchange_strong(expected, joule<int64_t>(7)) || expected != joule<int64_t>(1000) ||
+        !energy.compare_exchange_strong(expected, joule<int64_t>(7)) || energy.exchange(joule<int64_t>(0)) != joule<int64_t>(7)) {
+        return 1;
+    }
+    std::vector<std::thread> adders;
+    for (int t = 0; t < 4; ++t) {
+        adders.emplace_back([&] {
+            for (int i = 0; i < 10000; ++i) {
+                energy.fetch_add(joule<int64_t, std::kilo>(1) - joule<int64_t>(999));
+                energy_kj += joule<int64_t, std::kilo>(1);
+            }
+        });
+    }
+    for (auto& t : adders) {
+        t.join();
+    }
+    if (energy.load() != joule<int64_t>(40000) || energy_kj.load() != joule<double, std::kilo>(40001)) {
+        return 1;
+    }
+
+    su::sharded_counter<joule<int64_t>, 4> shared;
+    std::vector<std::thread> sharers;
+    for (int t = 0; t < 6; ++t) {
+        sharers.emplace_back([&] {
+            for (int i = 0; i < 10000; ++i) {
+                shared += joule<int64_t, std::kilo>(1);
+                shared.sub(joule<int64_t>(999));
+            }
+        });
+    }
+    for (auto& t : sharers) {
+        t.join();
+    }
+    if (shared.load() != joule<int64_t>(60000)) {
+        return 1;
+    }
+    shared.reset();
+    if (shared.load() != joule<int64_t>(0)) {
+        return 1;
+    }
+
+    std::vector<watt<double>> cancelling{watt<double>(1), watt<double>(1e100), watt<double>(1), watt<double>(-1e100)};
+    if (su::sum(cancelling) != watt<double>(2) || su::sum(std::list(cancelling.begin(), cancelling.end())) != watt<double>(2)) {
+        return 1;
+    }
+    std::vector<watt<double>> tenths(1'000'003, watt<double>(0.1));
+    for (auto total : {su::sum(tenths), su::sum(tenths, su::kahan), su::sum(tenths, su::pairwise)}) {
+        if (total.count() < 100000.3 - 1e-8 || total.count() > 100000.3 + 1e-8) {
+            return 1;
+        }
+    }
+    // Enough elements for every lane, and a tail
+    std::vector<watt<int32_t, std::milli>> readings(1003);
+    std::vector<watt<int64_t>> totals(1003);
+    int64_t expected_mw = 0;
+    for (std::size_t i = 0; i < readings.size(); ++i) {
+        readings[i] = watt<int32_t, std::milli>(i % 2 ? 2'000'000'000 - int32_t(i) : -int32_t(i));
+        totals[i] = watt<int64_t>(INT64_MAX - int64_t(i));
+        expected_mw += readings[i].count();
+    }
+    auto wide = su::accumulate(totals);
+    if (su::accumulate(readings) != watt<int64_t, std::milli>(expected_mw) ||
+        su::accumulate(readings | std::views::filter([](auto) { return true; })) != watt<int64_t, std::milli>(expected_mw) ||
+        wide.count() / 1003 != INT64_MAX - 501 || wide.count() % 1003 != 0 ||
+        su::reduce<watt<int64_t, std::kilo>>(std::span(totals).first(2)) != watt<int64_t, std::kilo>(18'446'744'073'709'551)) {
+        return 1;
+    }
+    try {
+        (void)su::reduce<watt<int64_t>>(std::span(totals).first(2));
+        return 1;
+    } catch (const std::overflow_error&) {
+    }
+    // Several chunks for each thread, and a partial chunk
+    su::thread_pool pool(4);
+    std::vector<watt<int32_t, std::milli>> many(1'000'003);
+    for (std::size_t i = 0; i < many.size(); ++i) {
+        many[i] = watt<int32_t, std::milli>(int32_t(i * 2654435761u));
+    }
+    std::vector<watt<double, std::kilo>> parallel_kw(many.size());
+    std::vector<watt<double, std::kilo>> expected_kw(many.size());
+    su::parallel::unit_cast(std::span<const watt<int32_t, std::milli>>(many), std::span(parallel_kw), su::strict, pool);
+    su::unit_cast(std::span(many), std::span(expected_kw));
+    std::vector<second<double>> durations(many.size(), second<double>(2));
+    std::vector<joule<double, std::kilo>> energies(many.size());
+    su::parallel::multiply(std::span<const watt<double, std::kilo>>(parallel_kw), std::span<const second<double>>(durations),
+        std::span(energies), pool);
+    auto [lowest, highest] = su::parallel::minmax(std::span(many), pool);
+    auto parallel_sum = su::parallel::sum(std::span(parallel_kw), su::neumaier, pool);
+    if (parallel_kw != expected_kw || su::parallel::accumulate(std::span(many), pool) != su::accumulate(many) ||
+        lowest != std::ranges::min(many) || highest != std::ranges::max(many) ||
+        std::abs((parallel_sum - su::sum(parallel_kw)).count()) > 1e-9 || energies[12345] != parallel_kw[12345] * second<double>(2)) {
+        return 1;
+    }
+    bool rethrown = false;
+    try {
+        pool.run(100, [](std::size_t i) {
+            if (i == 37) {
+                throw std::runtime_error("task");
+            }
+        });
+    } catch (const std::runtime_error&) {
+        rethrown = true;
+    }
+    if (!rethrown) {
+        return 1;
+    }
+
+    su::histogram<second<int64_t, std::micro>> latencies;
+    std::vector<std::thread> recorders;
+    for (int t = 0; t < 4; ++t) {
+        recorders.emplace_back([&] {
+            for (int64_t i = 1; i <= 1000; ++i) {
+                latencies.record(second<int64_t, std::nano>(i * 1000 + 999)); // truncated to i us
+            }
+        });
+    }
+    for (auto& t : recorders) {
+        t.join();
+    }
+    su::local_histogram<second<int64_t, std::micro>> slow;
+    slow.record(second<int64_t, std::milli>(250), 40);
+    slow.record(second<int64_t, std::micro>(-5));
+    auto merged = latencies.snapshot();
+    merged += slow.snapshot();
+    auto p50 = merged.percentile(50);
+    auto p99 = merged.percentile(99);
+    auto p999 = merged.percentile(99.9);
+    if (merged.count() != 4041 || merged.min() != second<int64_t, std::micro>(0) || merged.max() != second<int64_t, std::milli>(250) ||
+        p50 != second<int64_t, std::micro>(505) || p99 != second<int64_t, std::micro>(1003) || p999 != second<int64_t, std::milli>(250) || merged.percentile(0) != merged.min() || merged.percentile(100) != merged.max()) {
+        return 1;
+    }
+    latencies.merge(slow.snapshot());
+    if (latencies.snapshot().count() != 4041 || latencies.snapshot().percentile(99.9) != p999) {
+        return 1;
+    }
+    latencies.reset();
+    if (latencies.snapshot().count() != 0 || latencies.snapshot().percentile(50) != second<int64_t, std::micro>(0)) {
+        return 1;
+    }
+
+    // Far from zero, where the naive sum of squares loses every digit
+    std::vector<watt<double, std::kilo>> load(100'003);
+    for (std::size_t i = 0; i < load.size(); ++i) {
+        load[i] = watt<double, std::kilo>(1e9 + double(i % 7) - 3);
+    }
+    su::welford_accumulator<watt<double, std::kilo>> one_by_one;
+    for (const auto& x : load) {
+        one_by_one += x;
+    }
+    auto load_statistics = su::statistics(load);
+    auto parallel_statistics = su::parallel::statistics(std::span(load), pool);
+    auto halves = su::statistics(std::span(load).first(50'000)) + su::statistics(std::list(load.begin() + 50'000, load.end()));
+    for (const auto& st : {one_by_one, load_statistics, parallel_statistics, halves}) {
+        if (st.count() != 100'003 || std::abs(st.mean().count() - 1e9) > 1e-4 || std::abs(st.variance().count() - 4) > 1e-4 ||
+            std::abs(st.stddev().count() - 2) > 1e-4 || st.min() != watt<double, std::kilo>(1e9 - 3) || st.max() != watt<double, std::kilo>(1e9 + 3)) {
+            return 1;
+        }
+    }
+    su::welford_accumulator<watt<int32_t, std::milli>> single;
+    single += watt<int32_t>(2);
+    if (single.variance() != su::unit<su::squared_t<watt_t>, double, std::micro>(0) || single.sample_variance().count() != 0 ||
+        single.mean() != watt<double>(2) || su::statistics(std::span(many)).min() != lowest) {
+        return 1;
+    }
+
+    // Compared in nanoseconds, since system_clock may be coarser
+    auto now = std::chrono::time_point_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now());
+    ptp_point stamp = now;
+    if (std::chrono::sys_time<std::chrono::nanoseconds>(stamp + second<int64_t, std::milli>(3)) - now != std::chrono::milliseconds(3)) {
+        return 1;
+    }
+
+    std::vector<watt<float>> float_tenths(100'003, watt<float>(0.1f));
+    if (su::sum(float_tenths, su::kahan) != watt<float>(10000.3f) || su::sum(float_tenths) != watt<float>(10000.3f)) {
+        return 1;
+    }
+
+    su::ddsketch<watt<double>> power_sketch(0.01);
+    su::ddsketch<watt<double>> other_sketch(0.01);
+    for (int i = 1; i <= 10000; ++i) {
+        (i % 2 ? power_sketch : other_sketch).add(watt<int>(i));
+    }
+    other_sketch.add(watt<double, std::kilo>(-0.5), 10);
+    other_sketch.add(watt<double>(0));
+    if (!power_sketch.merge(other_sketch) || power_sketch.merge(su::ddsketch<watt<double>>(0.02)) || power_sketch.count() != 10011 ||
+        power_sketch.min() != watt<double>(-500) || power_sketch.max() != watt<double>(10000)) {
+        return 1;
+    }
+    for (double q : {0.01, 0.25, 0.5, 0.9, 0.99, 0.999}) {
+        double exact = std::floor(q * 10010) - 10;
+        if (std::abs(power_sketch.quantile(q).count() - exact) > 0.01 * exact) {
+            return 1;
+        }
+    }
+    if (power_sketch.quantile(0) != watt<double>(-500) || std::abs(power_sketch.quantile(0.0005).count() + 500) > 5 ||
+        power_sketch.quantile(0.001) != watt<double>(0) || power_sketch.quantile(1) != watt<double>(10000)) {
+        return 1;
+    }
+    auto sketch_bytes = power_sketch.serialize();
+    su::ddsketch<watt<double>> read_sketch;
+    if (read_sketch.deserialize(sketch_bytes) != su::sketch_errc::ok || read_sketch.count() != power_sketch.count() ||
+        read_sketch.quantile(0.99) != power_sketch.quantile(0.99) || read_sketch.relative_accuracy() != 0.01 ||
+        sketch_bytes.size() > power_sketch.bucket_count() * 3 + 64) {
+        return 1;
+    }
+    su::ddsketch<watt<int64_t, std::milli>> milliwatt_sketch;
+    if (milliwatt_sketch.deserialize(sketch_bytes) != su::sketch_errc::wrong_type ||
+        read_sketch.deserialize(std::span(sketch_bytes).first(sketch_bytes.size() - 1)) != su::sketch_errc::corrupt ||
+        read_sketch.deserialize(std::span(sketch_bytes).subspan(1)) != su::sketch_errc::not_a_sketch || read_sketch.count() != 10011) {
+        return 1;
+    }
+    // Hostile headers: bucket counts and limits that would need gigabytes,
+    // and an accuracy too fine for the bucket indexes to fit in an int
+    auto hostile_sketch = [&](double accuracy, std::uint64_t max_buckets, std::uint64_t n) {
+        std::vector<std::byte> bytes(sketch_bytes.begin(), sketch_bytes.begin() + 13);
+        auto put_varint = [&](std::uint64_t v) {
+            for (; v >= 0x80; v >>= 7) {
+                bytes.push_back(std::byte(v | 0x80));
+            }
+            bytes.push_back(std::byte(v));
+        };
+        for (int i = 0; i < 8; ++i) {
+            bytes.push_back(std::byte(std::bit_cast<std::uint64_t>(accuracy) >> (8 * i)));
+        }
+        put_varint(max_buckets);
+        put_varint(1);
+        put_varint(0);
+        for (int i = 0; i < 16; ++i) {
+            bytes.push_back(std::byte(0));
+        }
+        put_varint(0xFFFFFFFF); // offset -2^31
+        put_varint(n);
+        put_varint(1);
+        put_varint(0);
+        put_varint(0);
+        return read_sketch.deserialize(bytes);
+    };
+    if (hostile_sketch(0.01, std::uint64_t(1) << 32, std::uint64_t(1) << 31) != su::sketch_errc::corrupt ||
+        hostile_sketch(0.01, std::uint64_t(1) << 24, std::uint64_t(1) << 24) != su::sketch_errc::corrupt ||
+        hostile_sketch(1e-300, 2048, 1) != su::sketch_errc::corrupt || read_sketch.count() != 10011 ||
+        hostile_sketch(0.01, 2048, 1) != su::sketch_errc::ok || read_sketch.count() != 1) {
+        return 1;
+    }
+    su::ddsketch<watt<double>> narrow_sketch(0.01, 64);
+    for (int i = 1; i <= 1000; ++i) {
+        narrow_sketch.add(watt<double>(i));
+    }
+    if (narrow_sketch.bucket_count() != 64 || std::abs(narrow_sketch.quantile(0.99).count() - 990) > 9.9 ||
+        narrow_sketch.quantile(0.01).count() < 250) { // the lowest buckets are folded into one near 280 W
+        return 1;
+    }
+    milliwatt_sketch.add(watt<int>(3), 5);
+    if (milliwatt_sketch.quantile(0.5) != watt<int64_t, std::milli>(3000)) {
+        return 1;
+    }
+}
@@ -1,10 +1,13 @@
 #pragma once
 
+#include <array>
 #include <ratio>
 #include <concepts>
 #include <limits>
 #include <ostream>
 #include <chrono>
+#include <string_view>
+#include <utility>
 
 #define SU_MUL(lhs_1, lhs_2, rhs) \
     namespace su::ops { \
@@ -34,12 +37,199 @@
 namespace su
 {
 
+namespace detail
+{
+
+constexpr intmax_t abs(intmax_t a) {
+    return a < 0 ? -a : a;
+}
+
+constexpr intmax_t gcd(intmax_t a, intmax_t b) {
+    if (b == 0) {
+        return abs(a);
+    } else if (a == 0) {
+        return abs(b);
+    } else {
+        return gcd(b, a % b);
+    }
+}
+
+// True if v * R::den can overflow for some v of type Rep, even though the final
+// result of dividing by R::num may still be representable. Only possible when
+// the ratio has both a numerator and a denominator, which is never the case
+// between two SI prefixes.
+template <typename T, typename Rep, typename R>
+constexpr bool scale_may_overflow() {
+    if constexpr (!std::is_integral_v<T> || R::num == 1 || R::den == 1) {
+        return false;
+    } else {
+        using P = decltype(T() * R::den);
+        return std::cmp_greater(std::numeric_limits<Rep>::max(), std::numeric_limits<P>::max() / R::den) ||
+            std::cmp_less(std::numeric_limits<Rep>::lowest(), std::numeric_limits<P>::lowest() / R::den);
+    }
+}
+
+// Computes (v * R::den) / R::num without overflowing the intermediate product.
+// Splitting v into q * R::num + r keeps every product within the range of the
+// result, at the cost of one extra division by a constant. If R::num * R::den
+// itself does not fit, a 128-bit product is used instead.
+template <typename R, typename T>
+constexpr auto scale_wide(T v) {
+    using P = decltype(v * R::den);
+
+    if constexpr (std::cmp_less_equal(R::num, std::numeric_limits<P>::max() / R::den)) {
+        P q = v / R::num;
+        P r = v % R::num;
+        return q * R::den + (r * R::den) / R::num;
+    } else {
+#if defined(__SIZEOF_INT128__)
+        __extension__ using W = std::conditional_t<std::is_signed_v<P>, __int128, unsigned __int128>;
+        return P((W(v) * R::den) / R::num);
+#else
+        return (v * R::den) / R::num;
+#endif
+    }
+}
+
+// The SI prefix printed for a scale, or nullptr if it has none
+template <typename Scale>
+constexpr const char* si_prefix() {
+    if constexpr (std::is_same_v<Scale, std::exa>) { return "E"; }
+    else if constexpr (std::is_same_v<Scale, std::peta>) { return "P"; }
+    else if constexpr (std::is_same_v<Scale, std::tera>) { return "T"; }
+    else if constexpr (std::is_same_v<Scale, std::giga>) { return "G"; }
+    else if constexpr (std::is_same_v<Scale, std::mega>) { return "M"; }
+    else if constexpr (std::is_same_v<Scale, std::kilo>) { return "k"; }
+    else if constexpr (std::is_same_v<Scale, std::ratio<1>>) { return ""; }
+    else if constexpr (std::is_same_v<Scale, std::milli>) { return "m"; }
+    else if constexpr (std::is_same_v<Scale, std::micro>) { return "μ"; }
+    else if constexpr (std::is_same_v<Scale, std::nano>) { return "n"; }
+    else if constexpr (std::is_same_v<Scale, std::pico>) { return "p"; }
+    else if constexpr (std::is_same_v<Scale, std::femto>) { return "f"; }
+    else if constexpr (std::is_same_v<Scale, std::atto>) { return "a"; }
+    else { return nullptr; }
+}
+
+} // namespace detail
+
 template <typename Rep>
 struct treat_as_floating_point : std::is_floating_point<Rep> {};
 
 template <typename Tag>
 struct is_duration_type : std::false_type {};
 
+// The printable symbol of a tag. Defaults to Tag::symbol, and can be
+// specialized for tags that cannot carry one themselves.
+template <typename Tag>
+struct unit_symbol {};
+
+template <typename Tag>
+requires requires { Tag::symbol; }
+struct unit_symbol<Tag> { static constexpr auto value = Tag::symbol; };
+
+// Dimensionless quantities print without a symbol
+template <>
+struct unit_symbol<void> { static constexpr auto value = ""; };
+
+template <typename Tag>
+concept has_symbol = requires { unit_symbol<Tag>::value; };
+
+namespace detail
+{
+
+// Counts characters, and also writes them if out is not null, so that the
+// same code can size a static_text and then fill it
+struct text_sink
+{
+    char* out = nullptr;
+    std::size_t size = 0;
+
+    constexpr void put(std::string_view str) {
+        for (char c : str) {
+            if (out) {
+                out[size] = c;
+            }
+            ++size;
+        }
+    }
+
+    constexpr void put_int(intmax_t v) {
+        char digits[24] = {};
+        int i = 0;
+        if (v < 0) {
+            put("-");
+        }
+        do {
+            int d = int(v % 10);
+            digits[i++] = char('0' + (d < 0 ? -d : d));
+            v /= 10;
+        } while (v != 0);
+        while (i > 0) {
+            put(std::string_view(&digits[--i], 1));
+        }
+    }
+};
+
+// A null-terminated string built at compile time by Writer::write(text_sink&)
+template <typename Writer>
+struct static_text
+{
+    static constexpr std::size_t size = [] {
+        text_sink sink;
+        Writer::write(sink);
+        return sink.size;
+    }();
+
+    static constexpr std::array<char, size + 1> chars = [] {
+        std::array<char, size + 1> a{};
+        text_sink sink{a.data()};
+        Writer::write(sink);
+        return a;
+    }();
+};
+
+// True if the tag's symbol is made of several symbols, such as "m/s²", and so
+// needs parentheses after a prefix
+template <typename Tag>
+inline constexpr bool is_composite_symbol = requires { requires unit_symbol<Tag>::composite; };
+
+// The prefix and symbol of a unit. Dimensionless quantities have no symbol for
+// a prefix to attach to, so any scale but 1 is written in brackets.
+template <typename Tag, typename Scale>
+struct suffix_writer
+{
+    static constexpr void write(text_sink& sink) {
+        if constexpr (si_prefix<Scale>() != nullptr && (!std::is_void_v<Tag> || std::is_same_v<Scale, std::ratio<1>>)) {
+            sink.put(si_prefix<Scale>());
+        } else {
+            sink.put("[");
+            sink.put_int(Scale::num);
+            if constexpr (Scale::den != 1) {
+                sink.put("/");
+                sink.put_int(Scale::den);
+            }
+            sink.put("]");
+        }
+
+        if constexpr (is_composite_symbol<Tag> && !std::is_same_v<Scale, std::ratio<1>>) {
+            sink.put("(");
+            sink.put(unit_symbol<Tag>::value);
+            sink.put(")");
+        } else {
+            sink.put(unit_symbol<Tag>::value);
+        }
+    }
+};
+
+} // namespace detail
+
+// The prefix and symbol printed after the count of a unit, e.g. "kW"
+template <typename Tag, typename Scale = std::ratio<1>>
+requires has_symbol<Tag>
+inline constexpr std::string_view unit_suffix{
+    detail::static_text<detail::suffix_writer<Tag, Scale>>::chars.data(),
+    detail::static_text<detail::suffix_writer<Tag, Scale>>::size};
+
 template <typename Tag, typename Rep, typename Scale = std::ratio<1>>
 class unit
 {
@@ -73,12 +263,12 @@ public:
     constexpr unit operator+() const { return *this; }
     constexpr unit operator-() const { return unit(-m_val); }
 
-    constexpr unit& operator+=(const unit& u) { m_val += u.m_val; }
-    constexpr unit& operator-=(const unit& u) { m_val -= u.m_val; }
-    constexpr unit& operator*=(const Rep& v) { m_val *= v; }
-    constexpr unit& operator/=(const Rep& v) { m_val /= v; }
-    constexpr unit& operator%=(const unit& u) { m_val %= u.m_val; }
-    constexpr unit& operator%=(const Rep& v) { m_val %= v; }
+    constexpr unit& operator+=(const unit& u) { m_val += u.m_val; return *this; }
+    constexpr unit& operator-=(const unit& u) { m_val -= u.m_val; return *this; }
+    constexpr unit& operator*=(const Rep& v) { m_val *= v; return *this; }
+    constexpr unit& operator/=(const Rep& v) { m_val /= v; return *this; }
+    constexpr unit& operator%=(const unit& u) { m_val %= u.m_val; return *this; }
+    constexpr unit& operator%=(const Rep& v) { m_val %= v; return *this; }
 
     constexpr Rep count() const {
         return m_val;
@@ -108,6 +298,12 @@ using unit_i = unit<Tag, int64_t, Scale>;
 template <typename Rep, typename Scale>
 using quantity = unit<void, Rep, Scale>;
 
+template <typename T>
+struct is_unit : std::false_type {};
+
+template <typename Tag, typename Rep, typename Scale>
+struct is_unit<unit<Tag, Rep, Scale>> : std::true_type {};
+
 constexpr quantity<int64_t, std::nano> as_nano(1'000'000'000);
 constexpr quantity<int64_t, std::micro> as_micro(1'000'000);
 constexpr quantity<int64_t, std::milli> as_milli(1'000);
@@ -117,7 +313,43 @@ requires std::same_as<typename To::tag, Tag>
 constexpr To unit_cast(const unit<Tag, Rep, Scale>& u) {
     using R = std::ratio_divide<typename To::scale, Scale>;
     std::common_type_t<typename To::rep, Rep> v = u.count();
-    return To((v * R::den) / R::num);
+
+    if constexpr (detail::scale_may_overflow<decltype(v), Rep, R>()) {
+        return To(detail::scale_wide<R>(v));
+    } else {
+        return To((v * R::den) / R::num);
+    }
+}
+
+// Conversion policies. strict gives the same results as unit_cast(u). fast_math
+// folds the scale ratio into a single constant and multiplies by it, trading the
+// division for a relative error of at most 2u + u^2 (u = 2^-53 for double), i.e.
+// within 2 ulp of the exact value. The result is still bit-identical to strict
+// when the ratio is a whole number or a power of two. Integer reps are unaffected.
+struct strict_t { explicit strict_t() = default; };
+struct fast_math_t { explicit fast_math_t() = default; };
+
+inline constexpr strict_t strict{};
+inline constexpr fast_math_t fast_math{};
+
+template <typename To, typename Tag, typename Rep, typename Scale>
+requires std::same_as<typename To::tag, Tag>
+constexpr To unit_cast(const unit<Tag, Rep, Scale>& u, strict_t) {
+    return unit_cast<To>(u);
+}
+
+template <typename To, typename Tag, typename Rep, typename Scale>
+requires std::same_as<typename To::tag, Tag>
+constexpr To unit_cast(const unit<Tag, Rep, Scale>& u, fast_math_t) {
+    using R = std::ratio_divide<typename To::scale, Scale>;
+    using C = std::common_type_t<typename To::rep, Rep>;
+
+    if constexpr (treat_as_floating_point<C>::value) {
+        constexpr C factor = C(R::den) / C(R::num);
+        return To(C(u.count()) * factor);
+    } else {
+        return unit_cast<To>(u);
+    }
 }
 
 namespace ops
@@ -229,49 +461,12 @@ constexpr auto operator<=>(const unit<Tag, Rep1, Scale1>& a, const unit<Tag, Rep
 }
 
 template <typename Tag, typename Rep, typename Scale>
-requires requires { Tag::symbol; }
+requires has_symbol<Tag>
 std::ostream& operator<<(std::ostream& s, const unit<Tag, Rep, Scale>& u) {
     s << u.count();
-
-    if constexpr (std::is_same_v<Scale, std::exa>) { s << "E"; }
-    else if constexpr (std::is_same_v<Scale, std::peta>) { s << "P"; }
-    else if constexpr (std::is_same_v<Scale, std::tera>) { s << "T"; }
-    else if constexpr (std::is_same_v<Scale, std::giga>) { s << "G"; }
-    else if constexpr (std::is_same_v<Scale, std::mega>) { s << "M"; }
-    else if constexpr (std::is_same_v<Scale, std::kilo>) { s << "k"; }
-    else if constexpr (std::is_same_v<Scale, std::ratio<1>>) {}
-    else if constexpr (std::is_same_v<Scale, std::milli>) { s << "m"; }
-    else if constexpr (std::is_same_v<Scale, std::micro>) { s << "μ"; }
-    else if constexpr (std::is_same_v<Scale, std::nano>) { s << "n"; }
-    else if constexpr (std::is_same_v<Scale, std::pico>) { s << "p"; }
-    else if constexpr (std::is_same_v<Scale, std::femto>) { s << "f"; }
-    else if constexpr (std::is_same_v<Scale, std::atto>) { s << "a"; }
-    else if constexpr (Scale::den == 1) { s << "[" << Scale::num << "]"; }
-    else { s << "[" << Scale::num << "/" << Scale::den << "]"; }
-
-    s << Tag::symbol;
-    return s;
-}
-
-namespace detail
-{
-
-constexpr intmax_t abs(intmax_t a) {
-    return a < 0 ? -a : a;
+    return s.write(unit_suffix<Tag, Scale>.data(), std::streamsize(unit_suffix<Tag, Scale>.size()));
 }
 
-constexpr intmax_t gcd(intmax_t a, intmax_t b) {
-    if (b == 0) {
-        return abs(a);
-    } else if (a == 0) {
-        return abs(b);
-    } else {
-        return gcd(b, a % b);
-    }
-}
-
-} // namespace detail
-
 } // namespace su
 
 namespace std
@@ -0,0 +1,238 @@
+#pragma once
+
+#include <atomic>
+#include "units.hpp"
+
+// std::atomic for units, with fetch_add and fetch_sub. A unit of another scale
+// is converted to the atomic's scale before the atomic operation, under the
+// same rules as the unit's implicit conversions, so an atomic of W accepts kW
+// but an integer atomic of kW does not accept W. Integer reps use the native
+// atomic add. Floating point reps use std::atomic<Rep>::fetch_add where the
+// standard library provides it, and a compare-and-swap loop otherwise.
+//
+// su::sharded_counter spreads a heavily contended counter over a slot for
+// each thread, and sums the slots when it is read.
+
+template <typename Tag, typename Rep, typename Scale>
+requires std::is_arithmetic_v<Rep> && (!std::is_same_v<Rep, bool>)
+struct std::atomic<su::unit<Tag, Rep, Scale>>
+{
+    using value_type = su::unit<Tag, Rep, Scale>;
+    using difference_type = value_type;
+
+    static constexpr bool is_always_lock_free = std::atomic<Rep>::is_always_lock_free;
+
+    atomic() noexcept = default;
+    constexpr atomic(value_type u) noexcept : m_rep(u.count()) {}
+    atomic(const atomic&) = delete;
+    atomic& operator=(const atomic&) = delete;
+
+    bool is_lock_free() const noexcept {
+        return m_rep.is_lock_free();
+    }
+
+    void store(value_type u, std::memory_order order = std::memory_order_seq_cst) noexcept {
+        m_rep.store(u.count(), order);
+    }
+
+    value_type load(std::memory_order order = std::memory_order_seq_cst) const noexcept {
+        return value_type(m_rep.load(order));
+    }
+
+    operator value_type() const noexcept {
+        return load();
+    }
+
+    value_type operator=(value_type u) noexcept {
+        store(u);
+        return u;
+    }
+
+    value_type exchange(value_type u, std::memory_order order = std::memory_order_seq_cst) noexcept {
+        return value_type(m_rep.exchange(u.count(), order));
+    }
+
+    bool compare_exchange_weak(value_type& expected, value_type desired, std::memory_order success,
+        std::memory_order failure) noexcept {
+        Rep e = expected.count();
+        bool exchanged = m_rep.compare_exchange_weak(e, desired.count(), success, failure);
+        expected = value_type(e);
+        return exchanged;
+    }
+
+    bool compare_exchange_weak(value_type& expected, value_type desired,
+        std::memory_order order = std::memory_order_seq_cst) noexcept {
+        Rep e = expected.count();
+        bool exchanged = m_rep.compare_exchange_weak(e, desired.count(), order);
+        expected = value_type(e);
+        return exchanged;
+    }
+
+    bool compare_exchange_strong(value_type& expected, value_type desired, std::memory_order success,
+        std::memory_order failure) noexcept {
+        Rep e = expected.count();
+        bool exchanged = m_rep.compare_exchange_strong(e, desired.count(), success, failure);
+        expected = value_type(e);
+        return exchanged;
+    }
+
+    bool compare_exchange_strong(value_type& expected, value_type desired,
+        std::memory_order order = std::memory_order_seq_cst) noexcept {
+        Rep e = expected.count();
+        bool exchanged = m_rep.compare_exchange_strong(e, desired.count(), order);
+        expected = value_type(e);
+        return exchanged;
+    }
+
+    // Returns the value before the addition
+    template <typename Rep2, typename Scale2>
+    requires std::is_convertible_v<su::unit<Tag, Rep2, Scale2>, value_type>
+    value_type fetch_add(su::unit<Tag, Rep2, Scale2> u, std::memory_order order = std::memory_order_seq_cst) noexcept {
+        return value_type(apply<true>(value_type(u).count(), order));
+    }
+
+    // Returns the value before the subtraction
+    template <typename Rep2, typename Scale2>
+    requires std::is_convertible_v<su::unit<Tag, Rep2, Scale2>, value_type>
+    value_type fetch_sub(su::unit<Tag, Rep2, Scale2> u, std::memory_order order = std::memory_order_seq_cst) noexcept {
+        return value_type(apply<false>(value_type(u).count(), order));
+    }
+
+    // Return the value after the operation, as the compound operators of
+    // std::atomic do
+    template <typename Rep2, typename Scale2>
+    requires std::is_convertible_v<su::unit<Tag, Rep2, Scale2>, value_type>
+    value_type operator+=(su::unit<Tag, Rep2, Scale2> u) noexcept {
+        value_type d(u);
+        return fetch_add(d) + d;
+    }
+
+    template <typename Rep2, typename Scale2>
+    requires std::is_convertible_v<su::unit<Tag, Rep2, Scale2>, value_type>
+    value_type operator-=(su::unit<Tag, Rep2, Scale2> u) noexcept {
+        value_type d(u);
+        return fetch_sub(d) - d;
+    }
+
+    void wait(value_type old, std::memory_order order = std::memory_order_seq_cst) const noexcept {
+        m_rep.wait(old.count(), order);
+    }
+
+    void notify_one() noexcept {
+        m_rep.notify_one();
+    }
+
+    void notify_all() noexcept {
+        m_rep.notify_all();
+    }
+
+private:
+    // Adds or subtracts d, and returns the previous value
+    template <bool Add>
+    Rep apply(Rep d, std::memory_order order) noexcept {
+#if defined(__cpp_lib_atomic_float)
+        constexpr bool native = true;
+#else
+        constexpr bool native = std::is_integral_v<Rep>;
+#endif
+        if constexpr (!native) {
+            Rep old = m_rep.load(std::memory_order_relaxed);
+            while (!m_rep.compare_exchange_weak(old, Add ? old + d : old - d, order, std::memory_order_relaxed)) {
+            }
+            return old;
+        } else if constexpr (Add) {
+            return m_rep.fetch_add(d, order);
+        } else {
+            return m_rep.fetch_sub(d, order);
+        }
+    }
+
+    std::atomic<Rep> m_rep;
+};
+
+namespace su
+{
+
+namespace detail
+{
+
+// A slot index for the calling thread. Threads take consecutive indices when
+// they first ask, so that up to n threads each get a slot of their own.
+inline std::size_t thread_shard() {
+    static std::atomic<std::size_t> next{0};
+    thread_local std::size_t index = next.fetch_add(1, std::memory_order_relaxed);
+    return index;
+}
+
+} // namespace detail
+
+// A counter for units that many threads add to at once. Each thread adds to
+// one of Shards slots, each on its own cache line, so that threads do not
+// contend for one line as they would with a single atomic. load() sums the
+// slots, and is only exact once the adds it should see have finished.
+template <typename U, std::size_t Shards = 64>
+requires is_unit<U>::value && std::atomic<U>::is_always_lock_free
+class sharded_counter
+{
+public:
+    using value_type = U;
+
+    sharded_counter() = default;
+    sharded_counter(const sharded_counter&) = delete;
+    sharded_counter& operator=(const sharded_counter&) = delete;
+
+    template <typename Rep2, typename Scale2>
+    requires std::is_convertible_v<unit<typename U::tag, Rep2, Scale2>, U>
+    void add(unit<typename U::tag, Rep2, Scale2> u) noexcept {
+        slot().fetch_add(U(u), std::memory_order_relaxed);
+    }
+
+    template <typename Rep2, typename Scale2>
+    requires std::is_convertible_v<unit<typename U::tag, Rep2, Scale2>, U>
+    void sub(unit<typename U::tag, Rep2, Scale2> u) noexcept {
+        slot().fetch_sub(U(u), std::memory_order_relaxed);
+    }
+
+    template <typename Rep2, typename Scale2>
+    requires std::is_convertible_v<unit<typename U::tag, Rep2, Scale2>, U>
+    sharded_counter& operator+=(unit<typename U::tag, Rep2, Scale2> u) noexcept {
+        add(u);
+        return *this;
+    }
+
+    template <typename Rep2, typename Scale2>
+    requires std::is_convertible_v<unit<typename U::tag, Rep2, Scale2>, U>
+    sharded_counter& operator-=(unit<typename U::tag, Rep2, Scale2> u) noexcept {
+        sub(u);
+        return *this;
+    }
+
+    U load() const noexcept {
+        U total = U::zero();
+        for (const auto& s : m_slots) {
+            total += s.value.load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    // Sets every slot to zero. Adds made at the same time may be lost.
+    void reset() noexcept {
+        for (auto& s : m_slots) {
+            s.value.store(U::zero(), std::memory_order_relaxed);
+        }
+    }
+
+private:
+    struct alignas(64) padded
+    {
+        std::atomic<U> value{U::zero()};
+    };
+
+    std::atomic<U>& slot() noexcept {
+        return m_slots[detail::thread_shard() % Shards].value;
+    }
+
+    padded m_slots[Shards];
+};
+
+} // namespace su
@@ -0,0 +1,764 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "units.hpp"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace su
+{
+
+namespace detail
+{
+
+// Checks that an array of U can be accessed as an array of U::rep, and vice versa
+template <typename U>
+constexpr bool check_rep_layout() {
+    using Rep = typename U::rep;
+    static_assert(std::is_standard_layout_v<U>, "su::unit must be standard-layout to alias its rep");
+    static_assert(std::is_trivially_copyable_v<U>, "su::unit must be trivially copyable to alias its rep");
+    static_assert(sizeof(U) == sizeof(Rep), "su::unit must be the same size as its rep");
+    static_assert(alignof(U) == alignof(Rep), "su::unit must have the same alignment as its rep");
+    return true;
+}
+
+} // namespace detail
+
+namespace detail::simd
+{
+
+// Floating point lanes for the widest instruction set available. supports<T>
+// is true for every rep that can be loaded into (and stored from) a register
+// with a single conversion instruction. The AVX-512 conversions use the
+// zero-masked forms, which avoid spurious -Wuninitialized warnings from GCC 12.
+template <typename T>
+struct floats
+{
+    template <typename U>
+    static constexpr bool supports = false;
+};
+
+#if defined(__AVX512F__)
+
+template <>
+struct floats<double>
+{
+    using reg = __m512d;
+    static constexpr std::size_t width = 8;
+
+    template <typename T>
+    static constexpr bool supports = std::is_same_v<T, double> || std::is_same_v<T, float> || std::is_same_v<T, int32_t>
+#if defined(__AVX512DQ__)
+        || std::is_same_v<T, int64_t>
+#endif
+        ;
+
+    static reg set1(double v) { return _mm512_set1_pd(v); }
+    static reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+    static reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+    static reg min(reg a, reg b) { return _mm512_maskz_min_pd(0xFF, a, b); }
+    static reg max(reg a, reg b) { return _mm512_maskz_max_pd(0xFF, a, b); }
+
+    template <typename T>
+    static reg load(const T* p) {
+        if constexpr (std::is_same_v<T, double>) { return _mm512_loadu_pd(p); }
+        else if constexpr (std::is_same_v<T, float>) { return _mm512_maskz_cvtps_pd(0xFF, _mm256_loadu_ps(p)); }
+        else if constexpr (std::is_same_v<T, int32_t>) { return _mm512_maskz_cvtepi32_pd(0xFF, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))); }
+#if defined(__AVX512DQ__)
+        else { return _mm512_maskz_cvtepi64_pd(0xFF, _mm512_loadu_si512(p)); }
+#endif
+    }
+
+    template <typename T>
+    static void store(T* p, reg v) {
+        if constexpr (std::is_same_v<T, double>) { _mm512_storeu_pd(p, v); }
+        else if constexpr (std::is_same_v<T, float>) { _mm256_storeu_ps(p, _mm512_maskz_cvtpd_ps(0xFF, v)); }
+        else if constexpr (std::is_same_v<T, int32_t>) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm512_maskz_cvttpd_epi32(0xFF, v)); }
+#if defined(__AVX512DQ__)
+        else { _mm512_storeu_si512(p, _mm512_maskz_cvttpd_epi64(0xFF, v)); }
+#endif
+    }
+};
+
+#elif defined(__AVX2__)
+
+template <>
+struct floats<double>
+{
+    using reg = __m256d;
+    static constexpr std::size_t width = 4;
+
+    template <typename T>
+    static constexpr bool supports = std::is_same_v<T, double> || std::is_same_v<T, float> || std::is_same_v<T, int32_t>;
+
+    static reg set1(double v) { return _mm256_set1_pd(v); }
+    static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+    static reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+    static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+    static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+
+    template <typename T>
+    static reg load(const T* p) {
+        if constexpr (std::is_same_v<T, double>) { return _mm256_loadu_pd(p); }
+        else if constexpr (std::is_same_v<T, float>) { return _mm256_cvtps_pd(_mm_loadu_ps(p)); }
+        else { return _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))); }
+    }
+
+    template <typename T>
+    static void store(T* p, reg v) {
+        if constexpr (std::is_same_v<T, double>) { _mm256_storeu_pd(p, v); }
+        else if constexpr (std::is_same_v<T, float>) { _mm_storeu_ps(p, _mm256_cvtpd_ps(v)); }
+        else { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_cvttpd_epi32(v)); }
+    }
+};
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+template <>
+struct floats<double>
+{
+    using reg = float64x2_t;
+    static constexpr std::size_t width = 2;
+
+    template <typename T>
+    static constexpr bool supports = std::is_same_v<T, double> || std::is_same_v<T, int64_t>;
+
+    static reg set1(double v) { return vdupq_n_f64(v); }
+    static reg add(reg a, reg b) { return vaddq_f64(a, b); }
+    static reg sub(reg a, reg b) { return vsubq_f64(a, b); }
+    static reg mul(reg a, reg b) { return vmulq_f64(a, b); }
+    static reg div(reg a, reg b) { return vdivq_f64(a, b); }
+    static reg min(reg a, reg b) { return vminq_f64(a, b); }
+    static reg max(reg a, reg b) { return vmaxq_f64(a, b); }
+
+    template <typename T>
+    static reg load(const T* p) {
+        if constexpr (std::is_same_v<T, double>) { return vld1q_f64(p); }
+        else { return vcvtq_f64_s64(vld1q_s64(p)); }
+    }
+
+    template <typename T>
+    static void store(T* p, reg v) {
+        if constexpr (std::is_same_v<T, double>) { vst1q_f64(p, v); }
+        else { vst1q_s64(p, vcvtq_s64_f64(v)); }
+    }
+};
+
+#endif
+
+// Integer lanes, only provided where the instruction set has a native
+// element-wise multiply for T. There is no vector integer division.
+template <typename T>
+struct ints
+{
+    template <typename U>
+    static constexpr bool supports = false;
+};
+
+#if defined(__AVX512F__)
+
+template <>
+struct ints<int32_t>
+{
+    using reg = __m512i;
+    static constexpr std::size_t width = 16;
+
+    template <typename U>
+    static constexpr bool supports = std::is_same_v<U, int32_t>;
+
+    static reg set1(int32_t v) { return _mm512_set1_epi32(v); }
+    static reg add(reg a, reg b) { return _mm512_add_epi32(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_epi32(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mullo_epi32(a, b); }
+    static reg load(const int32_t* p) { return _mm512_loadu_si512(p); }
+    static void store(int32_t* p, reg v) { _mm512_storeu_si512(p, v); }
+};
+
+#if defined(__AVX512DQ__)
+template <>
+struct ints<int64_t>
+{
+    using reg = __m512i;
+    static constexpr std::size_t width = 8;
+
+    template <typename U>
+    static constexpr bool supports = std::is_same_v<U, int64_t>;
+
+    static reg set1(int64_t v) { return _mm512_set1_epi64(v); }
+    static reg add(reg a, reg b) { return _mm512_add_epi64(a, b); }
+    static reg sub(reg a, reg b) { return _mm512_sub_epi64(a, b); }
+    static reg mul(reg a, reg b) { return _mm512_mullo_epi64(a, b); }
+    static reg load(const int64_t* p) { return _mm512_loadu_si512(p); }
+    static void store(int64_t* p, reg v) { _mm512_storeu_si512(p, v); }
+};
+#endif
+
+#elif defined(__AVX2__)
+
+template <>
+struct ints<int32_t>
+{
+    using reg = __m256i;
+    static constexpr std::size_t width = 8;
+
+    template <typename U>
+    static constexpr bool supports = std::is_same_v<U, int32_t>;
+
+    static reg set1(int32_t v) { return _mm256_set1_epi32(v); }
+    static reg add(reg a, reg b) { return _mm256_add_epi32(a, b); }
+    static reg sub(reg a, reg b) { return _mm256_sub_epi32(a, b); }
+    static reg mul(reg a, reg b) { return _mm256_mullo_epi32(a, b); }
+    static reg load(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    static void store(int32_t* p, reg v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+};
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+template <>
+struct ints<int32_t>
+{
+    using reg = int32x4_t;
+    static constexpr std::size_t width = 4;
+
+    template <typename U>
+    static constexpr bool supports = std::is_same_v<U, int32_t>;
+
+    static reg set1(int32_t v) { return vdupq_n_s32(v); }
+    static reg add(reg a, reg b) { return vaddq_s32(a, b); }
+    static reg sub(reg a, reg b) { return vsubq_s32(a, b); }
+    static reg mul(reg a, reg b) { return vmulq_s32(a, b); }
+    static reg load(const int32_t* p) { return vld1q_s32(p); }
+    static void store(int32_t* p, reg v) { vst1q_s32(p, v); }
+};
+
+#endif
+
+template <typename C>
+using lanes = std::conditional_t<treat_as_floating_point<C>::value, floats<C>, ints<C>>;
+
+template <typename L>
+concept divisible = requires (typename L::reg r) { L::div(r, r); };
+
+// True if T can be loaded into lanes L and rescaled by R the same way unit_cast
+// would. Integer lanes can only rescale by whole numbers.
+template <typename L, typename R, typename T>
+constexpr bool can_load = L::template supports<T> && (R::num == 1 || divisible<L>);
+
+template <typename L, typename C, typename R, typename T>
+auto load_scaled(const T* p) {
+    auto v = L::load(p);
+    if constexpr (R::den != 1) { v = L::mul(v, L::set1(static_cast<C>(R::den))); }
+    if constexpr (R::num != 1) { v = L::div(v, L::set1(static_cast<C>(R::num))); }
+    return v;
+}
+
+// Converts as many leading elements as the vector kernels can handle, and
+// returns how many were converted. Each kernel performs exactly the same
+// operations as the scalar unit_cast with the same policy, so results are
+// bit-identical. Integer division by the constant R::num is left to the scalar
+// loop, which the compiler lowers to a multiply-high sequence.
+template <typename C, typename R, typename Policy, typename From, typename To>
+std::size_t cast(const From* in, To* out, std::size_t n) {
+    using L = lanes<C>;
+    std::size_t i = 0;
+
+    if constexpr (can_load<L, R, From> && L::template supports<To>) {
+        if constexpr (std::is_same_v<Policy, fast_math_t> && treat_as_floating_point<C>::value) {
+            const auto factor = L::set1(C(R::den) / C(R::num));
+            for (; i + L::width <= n; i += L::width) {
+                L::store(out + i, L::mul(L::load(in + i), factor));
+            }
+        } else {
+            for (; i + L::width <= n; i += L::width) {
+                L::store(out + i, load_scaled<L, C, R>(in + i));
+            }
+        }
+    }
+
+    return i;
+}
+
+// Maps the standard function objects used by the unit_vector operators onto
+// lane operations. Addition and subtraction rescale both operands to the common
+// scale first, multiplication and division combine the scales instead.
+template <typename Op>
+struct lane_op {};
+
+template <>
+struct lane_op<std::plus<>>
+{
+    static constexpr bool rescales = true;
+    template <typename L> static auto apply(auto a, auto b) { return L::add(a, b); }
+};
+
+template <>
+struct lane_op<std::minus<>>
+{
+    static constexpr bool rescales = true;
+    template <typename L> static auto apply(auto a, auto b) { return L::sub(a, b); }
+};
+
+template <>
+struct lane_op<std::multiplies<>>
+{
+    static constexpr bool rescales = false;
+    template <typename L> static auto apply(auto a, auto b) { return L::mul(a, b); }
+};
+
+template <>
+struct lane_op<std::divides<>>
+{
+    static constexpr bool rescales = false;
+    template <typename L> requires divisible<L> static auto apply(auto a, auto b) { return L::div(a, b); }
+};
+
+template <typename L, typename Op>
+concept has_lane_op = requires (typename L::reg r) { lane_op<Op>::template apply<L>(r, r); };
+
+// Computes out[i] = op(a[i], b[i]) for as many leading elements as the vector
+// kernels can handle, where T is the unit produced by op. b is either a pointer
+// to the reps of a second unit array, or a plain scalar.
+template <typename Op, typename T, typename A, typename B, typename BSrc>
+std::size_t zip(const typename A::rep* a, BSrc b, typename T::rep* out, std::size_t n) {
+    using C = typename T::rep;
+    using L = lanes<C>;
+    using RA = std::conditional_t<lane_op<Op>::rescales, std::ratio_divide<typename T::scale, typename A::scale>, std::ratio<1>>;
+    std::size_t i = 0;
+
+    if constexpr (std::is_pointer_v<BSrc>) {
+        using RB = std::conditional_t<lane_op<Op>::rescales, std::ratio_divide<typename T::scale, typename B::scale>, std::ratio<1>>;
+        if constexpr (has_lane_op<L, Op> && can_load<L, RA, typename A::rep> && can_load<L, RB, typename B::rep> && L::template supports<C>) {
+            for (; i + L::width <= n; i += L::width) {
+                L::store(out + i, lane_op<Op>::template apply<L>(load_scaled<L, C, RA>(a + i), load_scaled<L, C, RB>(b + i)));
+            }
+        }
+    } else {
+        if constexpr (has_lane_op<L, Op> && can_load<L, RA, typename A::rep> && L::template supports<C>) {
+            const auto s = L::set1(static_cast<C>(b));
+            for (; i + L::width <= n; i += L::width) {
+                L::store(out + i, lane_op<Op>::template apply<L>(load_scaled<L, C, RA>(a + i), s));
+            }
+        }
+    }
+
+    return i;
+}
+
+} // namespace detail::simd
+
+// Converts every element of in, writing the results to the front of out.
+// out must be at least as long as in. Returns the written part of out.
+template <typename To, typename From, std::size_t E1, std::size_t E2, typename Policy = strict_t>
+requires is_unit<std::remove_const_t<From>>::value && std::same_as<typename To::tag, typename From::tag> &&
+    (std::same_as<Policy, strict_t> || std::same_as<Policy, fast_math_t>)
+constexpr std::span<To> unit_cast(std::span<From, E1> in, std::span<To, E2> out, Policy policy = Policy()) {
+    using FromRep = typename From::rep;
+    using ToRep = typename To::rep;
+    using R = std::ratio_divide<typename To::scale, typename From::scale>;
+    using C = std::common_type_t<ToRep, FromRep>;
+    static_assert(detail::check_rep_layout<std::remove_const_t<From>>() && detail::check_rep_layout<To>());
+
+    assert(out.size() >= in.size());
+
+    std::size_t i = 0;
+    if (!std::is_constant_evaluated()) {
+        i = detail::simd::cast<C, R, Policy>(reinterpret_cast<const FromRep*>(in.data()), reinterpret_cast<ToRep*>(out.data()), in.size());
+    }
+    for (; i < in.size(); ++i) {
+        out[i] = unit_cast<To>(in[i], policy);
+    }
+
+    return out.first(in.size());
+}
+
+// A non-owning view of units, which may alias a raw array of reps
+template <typename Tag, typename Rep, typename Scale = std::ratio<1>, std::size_t Extent = std::dynamic_extent>
+using unit_span = std::span<unit<Tag, Rep, Scale>, Extent>;
+
+// Reinterprets raw reps as units of the given tag and scale, without copying.
+// The result is const if Rep is const.
+template <typename Tag, typename Scale = std::ratio<1>, typename Rep, std::size_t Extent>
+requires std::is_arithmetic_v<std::remove_const_t<Rep>>
+auto as_units(std::span<Rep, Extent> raw) {
+    using U = unit<Tag, std::remove_const_t<Rep>, Scale>;
+    using T = std::conditional_t<std::is_const_v<Rep>, const U, U>;
+    static_assert(detail::check_rep_layout<U>());
+
+#if defined(__cpp_lib_start_lifetime_as)
+    T* p = std::start_lifetime_as_array<T>(raw.data(), raw.size());
+#else
+    T* p = reinterpret_cast<T*>(raw.data());
+#endif
+    return std::span<T, Extent>(p, raw.size());
+}
+
+template <typename Tag, typename Scale = std::ratio<1>, typename Rep>
+requires std::is_arithmetic_v<std::remove_const_t<Rep>>
+auto as_units(Rep* data, std::size_t n) {
+    return as_units<Tag, Scale>(std::span<Rep>(data, n));
+}
+
+// A lazily converted view of a contiguous range of units. Each element is
+// converted with unit_cast when it is read. The source stays available as a
+// contiguous span, so blocks of it can be converted with the bulk unit_cast.
+template <typename To, typename From, typename Policy = strict_t>
+class unit_cast_view : public std::ranges::view_interface<unit_cast_view<To, From, Policy>>
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_concept = std::random_access_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = To;
+        using difference_type = std::ptrdiff_t;
+
+        constexpr iterator() = default;
+        constexpr explicit iterator(const From* p) : m_p(p) {}
+
+        constexpr To operator*() const { return su::unit_cast<To>(*m_p, Policy()); }
+        constexpr To operator[](difference_type n) const { return su::unit_cast<To>(m_p[n], Policy()); }
+
+        constexpr iterator& operator++() { ++m_p; return *this; }
+        constexpr iterator& operator--() { --m_p; return *this; }
+        constexpr iterator operator++(int) { return iterator(m_p++); }
+        constexpr iterator operator--(int) { return iterator(m_p--); }
+        constexpr iterator& operator+=(difference_type n) { m_p += n; return *this; }
+        constexpr iterator& operator-=(difference_type n) { m_p -= n; return *this; }
+
+        friend constexpr iterator operator+(iterator it, difference_type n) { return it += n; }
+        friend constexpr iterator operator+(difference_type n, iterator it) { return it += n; }
+        friend constexpr iterator operator-(iterator it, difference_type n) { return it -= n; }
+        friend constexpr difference_type operator-(const iterator& a, const iterator& b) { return a.m_p - b.m_p; }
+        friend constexpr bool operator==(const iterator& a, const iterator& b) = default;
+        friend constexpr auto operator<=>(const iterator& a, const iterator& b) = default;
+
+    private:
+        const From* m_p = nullptr;
+    };
+
+    constexpr unit_cast_view() = default;
+    constexpr explicit unit_cast_view(std::span<const From> source) : m_source(source) {}
+
+    constexpr iterator begin() const { return iterator(m_source.data()); }
+    constexpr iterator end() const { return iterator(m_source.data() + m_source.size()); }
+    constexpr std::size_t size() const { return m_source.size(); }
+
+    // The unconverted elements
+    constexpr std::span<const From> source() const { return m_source; }
+
+    // Converts every element into the front of out, using the bulk unit_cast
+    constexpr std::span<To> convert(std::span<To> out) const { return su::unit_cast(m_source, out, Policy()); }
+
+private:
+    std::span<const From> m_source;
+};
+
+namespace views
+{
+
+// A range adaptor closure. Applying it to a range with | calls f, and piping
+// one closure into another composes them.
+template <typename F>
+struct closure
+{
+    F f;
+
+    template <typename R>
+    requires std::invocable<const F&, R>
+    constexpr auto operator()(R&& r) const {
+        return f(std::forward<R>(r));
+    }
+
+    template <typename R>
+    requires std::invocable<const F&, R>
+    friend constexpr auto operator|(R&& r, const closure& c) {
+        return c.f(std::forward<R>(r));
+    }
+
+    template <typename G>
+    friend constexpr auto operator|(const closure& a, const closure<G>& b) {
+        auto composed = [a, b](auto&& r)
+        requires requires { b.f(a.f(std::forward<decltype(r)>(r))); }
+        {
+            return b.f(a.f(std::forward<decltype(r)>(r)));
+        };
+        return closure<decltype(composed)>{composed};
+    }
+};
+
+// The views only refer to the range, so they take borrowed ranges, such as
+// lvalue containers and spans, and not temporaries that would dangle
+template <typename Tag, typename Scale>
+struct as_units_fn
+{
+    template <std::ranges::contiguous_range R>
+    requires std::ranges::sized_range<R> && std::ranges::borrowed_range<R>
+    constexpr auto operator()(R&& r) const {
+        return su::as_units<Tag, Scale>(std::span(std::forward<R>(r)));
+    }
+};
+
+template <typename To, typename Policy>
+struct unit_cast_fn
+{
+    template <std::ranges::contiguous_range R>
+    requires std::ranges::sized_range<R> && std::ranges::borrowed_range<R> && is_unit<std::ranges::range_value_t<R>>::value
+    constexpr auto operator()(R&& r) const {
+        using From = std::ranges::range_value_t<R>;
+        return unit_cast_view<To, From, Policy>(std::span<const From>(std::forward<R>(r)));
+    }
+};
+
+// Splits a unit_cast_view into consecutive unit_cast_views of at most n
+// elements, and any other contiguous range into spans of at most n elements.
+// n must be greater than zero.
+struct chunk_fn
+{
+    std::size_t n;
+
+    template <typename To, typename From, typename Policy>
+    constexpr auto operator()(const unit_cast_view<To, From, Policy>& v) const {
+        return split(v.source(), [](std::span<const From> s) { return unit_cast_view<To, From, Policy>(s); });
+    }
+
+    template <std::ranges::contiguous_range R>
+    requires std::ranges::sized_range<R> && std::ranges::borrowed_range<R>
+    constexpr auto operator()(R&& r) const {
+        return split(std::span(std::forward<R>(r)), std::identity());
+    }
+
+private:
+    template <typename T, typename F>
+    constexpr auto split(std::span<T> s, F make) const {
+        assert(n > 0);
+        std::size_t count = (s.size() + n - 1) / n;
+        return std::views::iota(std::size_t(0), count) | std::views::transform([s, n = n, make](std::size_t i) {
+            return make(s.subspan(i * n, std::min(n, s.size() - i * n)));
+        });
+    }
+};
+
+// e.g. raw | su::views::as_units<watt_t, std::milli>
+template <typename Tag, typename Scale = std::ratio<1>>
+inline constexpr closure<as_units_fn<Tag, Scale>> as_units{};
+
+// e.g. readings | su::views::unit_cast<kilowatt_d>
+template <typename To, typename Policy = strict_t>
+inline constexpr closure<unit_cast_fn<To, Policy>> unit_cast{};
+
+// e.g. readings | su::views::unit_cast<kilowatt_d> | su::views::chunk(4096)
+constexpr closure<chunk_fn> chunk(std::size_t n) {
+    return {chunk_fn{n}};
+}
+
+} // namespace views
+
+namespace detail
+{
+
+template <typename T, std::size_t Align>
+struct aligned_allocator
+{
+    using value_type = T;
+
+    template <typename U>
+    struct rebind { using other = aligned_allocator<U, Align>; };
+
+    constexpr aligned_allocator() = default;
+
+    template <typename U>
+    constexpr aligned_allocator(const aligned_allocator<U, Align>&) {}
+
+    constexpr T* allocate(std::size_t n) {
+        if (std::is_constant_evaluated()) {
+            return std::allocator<T>().allocate(n);
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Align)));
+    }
+
+    constexpr void deallocate(T* p, std::size_t n) {
+        if (std::is_constant_evaluated()) {
+            std::allocator<T>().deallocate(p, n);
+        } else {
+            ::operator delete(p, n * sizeof(T), std::align_val_t(Align));
+        }
+    }
+
+    friend constexpr bool operator==(const aligned_allocator&, const aligned_allocator&) = default;
+};
+
+} // namespace detail
+
+// A contiguous, owning array of units whose storage is aligned for the widest
+// vector registers. The whole-array operators run as single fused passes over
+// the underlying reps, with any scale conversion folded into the same pass.
+template <typename Tag, typename Rep, typename Scale = std::ratio<1>>
+class unit_vector
+{
+public:
+    using tag = Tag;
+    using rep = Rep;
+    using scale = Scale;
+    using value_type = unit<Tag, Rep, Scale>;
+    using size_type = std::size_t;
+    using iterator = value_type*;
+    using const_iterator = const value_type*;
+
+    static constexpr std::size_t alignment = 64;
+
+    constexpr unit_vector() = default;
+    constexpr explicit unit_vector(size_type n) : m_data(n) {}
+    constexpr unit_vector(size_type n, const value_type& v) : m_data(n, v) {}
+    constexpr unit_vector(std::initializer_list<value_type> init) : m_data(init) {}
+
+    constexpr value_type& operator[](size_type i) { return m_data[i]; }
+    constexpr const value_type& operator[](size_type i) const { return m_data[i]; }
+
+    constexpr iterator begin() { return m_data.data(); }
+    constexpr iterator end() { return m_data.data() + m_data.size(); }
+    constexpr const_iterator begin() const { return m_data.data(); }
+    constexpr const_iterator end() const { return m_data.data() + m_data.size(); }
+
+    constexpr size_type size() const { return m_data.size(); }
+    constexpr bool empty() const { return m_data.empty(); }
+
+    constexpr void resize(size_type n) { m_data.resize(n); }
+    constexpr void reserve(size_type n) { m_data.reserve(n); }
+    constexpr void clear() { m_data.clear(); }
+    constexpr void push_back(const value_type& v) { m_data.push_back(v); }
+
+    constexpr std::span<value_type> units() { return m_data; }
+    constexpr std::span<const value_type> units() const { return m_data; }
+
+    // The underlying reps, with no scaling applied
+    std::span<Rep> raw() { return {reinterpret_cast<Rep*>(m_data.data()), m_data.size()}; }
+    std::span<const Rep> raw() const { return {reinterpret_cast<const Rep*>(m_data.data()), m_data.size()}; }
+
+private:
+    static_assert(detail::check_rep_layout<value_type>());
+
+    std::vector<value_type, detail::aligned_allocator<value_type, alignment>> m_data;
+};
+
+namespace detail
+{
+
+// The unit_vector holding results of type T. Operators that produce a plain
+// number, such as dividing two units of the same tag, give a vector of quantities.
+template <typename T>
+struct vector_of { using type = unit_vector<void, T>; };
+
+template <typename Tag, typename Rep, typename Scale>
+struct vector_of<unit<Tag, Rep, Scale>> { using type = unit_vector<Tag, Rep, Scale>; };
+
+template <typename Op, typename A, typename B>
+constexpr auto zip(std::span<const A> a, std::span<const B> b, Op op) {
+    using T = decltype(op(a[0], b[0]));
+    using V = typename vector_of<T>::type;
+
+    V out(a.size());
+    std::size_t i = 0;
+
+    if constexpr (is_unit<T>::value) {
+        if (!std::is_constant_evaluated()) {
+            i = simd::zip<Op, T, A, B>(reinterpret_cast<const typename A::rep*>(a.data()), reinterpret_cast<const typename B::rep*>(b.data()), out.raw().data(), a.size());
+        }
+    }
+    for (; i < a.size(); ++i) {
+        out[i] = typename V::value_type(op(a[i], b[i]));
+    }
+
+    return out;
+}
+
+template <typename Op, typename A, typename T>
+constexpr auto zip_scalar(std::span<const A> a, const T& b, Op op) {
+    using U = decltype(op(a[0], b));
+    typename vector_of<U>::type out(a.size());
+    std::size_t i = 0;
+
+    if (!std::is_constant_evaluated()) {
+        i = simd::zip<Op, U, A, T>(reinterpret_cast<const typename A::rep*>(a.data()), b, out.raw().data(), a.size());
+    }
+    for (; i < a.size(); ++i) {
+        out[i] = op(a[i], b);
+    }
+
+    return out;
+}
+
+} // namespace detail
+
+template <typename Tag, typename Rep1, typename Scale1, typename Rep2, typename Scale2>
+constexpr auto operator+(const unit_vector<Tag, Rep1, Scale1>& a, const unit_vector<Tag, Rep2, Scale2>& b) {
+    assert(a.size() == b.size());
+    return detail::zip(a.units(), b.units(), std::plus<>());
+}
+
+template <typename Tag, typename Rep1, typename Scale1, typename Rep2, typename Scale2>
+constexpr auto operator-(const unit_vector<Tag, Rep1, Scale1>& a, const unit_vector<Tag, Rep2, Scale2>& b) {
+    assert(a.size() == b.size());
+    return detail::zip(a.units(), b.units(), std::minus<>());
+}
+
+template <typename Tag1, typename Rep1, typename Scale1, typename Tag2, typename Rep2, typename Scale2>
+requires requires { typename ops::mul<Tag1, Tag2>::type; }
+constexpr auto operator*(const unit_vector<Tag1, Rep1, Scale1>& a, const unit_vector<Tag2, Rep2, Scale2>& b) {
+    assert(a.size() == b.size());
+    return detail::zip(a.units(), b.units(), std::multiplies<>());
+}
+
+template <typename Tag1, typename Rep1, typename Scale1, typename Tag2, typename Rep2, typename Scale2>
+requires requires { typename ops::div<Tag1, Tag2>::type; }
+constexpr auto operator/(const unit_vector<Tag1, Rep1, Scale1>& a, const unit_vector<Tag2, Rep2, Scale2>& b) {
+    assert(a.size() == b.size());
+    return detail::zip(a.units(), b.units(), std::divides<>());
+}
+
+template <typename T, typename Tag, typename Rep, typename Scale>
+requires requires { typename std::common_type<Rep, T>::type; }
+constexpr auto operator*(const unit_vector<Tag, Rep, Scale>& a, const T& b) {
+    return detail::zip_scalar(a.units(), b, std::multiplies<>());
+}
+
+template <typename T, typename Tag, typename Rep, typename Scale>
+requires requires { typename std::common_type<Rep, T>::type; }
+constexpr auto operator*(const T& a, const unit_vector<Tag, Rep, Scale>& b) {
+    return b * a;
+}
+
+template <typename T, typename Tag, typename Rep, typename Scale>
+requires requires { typename std::common_type<Rep, T>::type; }
+constexpr auto operator/(const unit_vector<Tag, Rep, Scale>& a, const T& b) {
+    return detail::zip_scalar(a.units(), b, std::divides<>());
+}
+
+} // namespace su
+
+namespace std::ranges
+{
+
+template <typename To, typename From, typename Policy>
+inline constexpr bool enable_borrowed_range<su::unit_cast_view<To, From, Policy>> = true;
+
+} // namespace std::ranges
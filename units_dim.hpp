@@ -0,0 +1,233 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <string_view>
+#include <utility>
+#include "units.hpp"
+
+// An alternative to SU_UNIT tags, where each tag is a vector of exponents over
+// a set of base dimensions chosen by the user. Products and quotients of these
+// tags are derived automatically, so no SU_MUL declarations are needed, and
+// chains such as J / s / s work without declaring every intermediate relation.
+
+// Creates a tag called "name" with the given exponents, and a printable symbol
+// "symbol_str". Only one symbol can be given to each distinct set of exponents.
+// e.g. SU_DIM_UNIT(newton_t, "N", -2, 1, 1) for time, length and mass
+#define SU_DIM_UNIT(name, symbol_str, ...) \
+    using name = su::dim_t<__VA_ARGS__>; \
+    namespace su { \
+        template <> \
+        struct unit_symbol<name> { static constexpr auto value = symbol_str; }; \
+    }
+
+// As SU_DIM_UNIT, but the unit is also implicitly convertible to std::chrono::duration
+#define SU_DIM_DURATION_UNIT(name, symbol_str, ...) \
+    SU_DIM_UNIT(name, symbol_str, __VA_ARGS__) \
+    namespace su { \
+        template <> \
+        struct is_duration_type<name> : std::true_type {}; \
+    }
+
+namespace su
+{
+
+// Exponents of each base dimension, in an order chosen by the user. Trailing
+// zero exponents are omitted, so that each dimension has a single type.
+template <int... Exponents>
+struct dim {};
+
+namespace detail
+{
+
+// Removes trailing zero exponents. If every exponent is zero the quantity is
+// dimensionless, which is represented by void as elsewhere in the library.
+template <int... E>
+struct canonical_dim
+{
+    static constexpr int exps[] = {E..., 0};
+
+    static constexpr std::size_t length = [] {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < sizeof...(E); ++i) {
+            if (exps[i] != 0) {
+                n = i + 1;
+            }
+        }
+        return n;
+    }();
+
+    template <std::size_t... I>
+    static auto make(std::index_sequence<I...>) -> dim<exps[I]...>;
+
+    using type = std::conditional_t<length == 0, void, decltype(make(std::make_index_sequence<length>()))>;
+};
+
+// Adds (Sign = 1) or subtracts (Sign = -1) the exponents of two dimensions
+template <typename A, typename B, int Sign>
+struct combine_dims;
+
+template <int... A, int... B, int Sign>
+struct combine_dims<dim<A...>, dim<B...>, Sign>
+{
+    static constexpr int a[] = {A..., 0};
+    static constexpr int b[] = {B..., 0};
+
+    static constexpr int at(std::size_t i) {
+        return (i < sizeof...(A) ? a[i] : 0) + Sign * (i < sizeof...(B) ? b[i] : 0);
+    }
+
+    template <std::size_t... I>
+    static auto make(std::index_sequence<I...>) -> typename canonical_dim<at(I)...>::type;
+
+    using type = decltype(make(std::make_index_sequence<std::max(sizeof...(A), sizeof...(B))>()));
+};
+
+} // namespace detail
+
+template <int... Exponents>
+using dim_t = typename detail::canonical_dim<Exponents...>::type;
+
+namespace detail
+{
+
+// dim<0, ..., 0, 1> with the 1 at index I
+template <std::size_t I, std::size_t... J>
+auto make_base_dim(std::index_sequence<J...>) -> dim<(J == I ? 1 : 0)...>;
+
+template <std::size_t I>
+using base_dim = decltype(make_base_dim<I>(std::make_index_sequence<I + 1>()));
+
+inline constexpr std::string_view superscript_digits[] = {"⁰", "¹", "²", "³", "⁴", "⁵", "⁶", "⁷", "⁸", "⁹"};
+
+constexpr void put_superscript(text_sink& sink, int e) {
+    if (e >= 10) {
+        put_superscript(sink, e / 10);
+    }
+    sink.put(superscript_digits[e % 10]);
+}
+
+// Writes a symbol made from the symbols of the base dimensions, with positive
+// exponents before a '/' and negative exponents after it, e.g. "m²·kg/s³". If
+// every exponent is negative they are written as such, e.g. "s⁻¹", so that the
+// symbol cannot run into the count.
+template <int... E>
+struct composite_symbol_writer
+{
+    static constexpr int exps[] = {E...};
+
+    template <std::size_t I>
+    static constexpr std::string_view base_symbol() {
+        if constexpr (exps[I] == 0) {
+            return {};
+        } else {
+            return unit_symbol<base_dim<I>>::value;
+        }
+    }
+
+    template <std::size_t I>
+    static constexpr bool base_named() {
+        if constexpr (exps[I] == 0) {
+            return true;
+        } else {
+            return has_symbol<base_dim<I>>;
+        }
+    }
+
+    // A single base dimension, which has to be named rather than composed
+    static constexpr bool is_base = [] {
+        int nonzero = 0;
+        for (int e : exps) {
+            nonzero += e != 0;
+        }
+        return nonzero == 1 && exps[sizeof...(E) - 1] == 1;
+    }();
+
+    static constexpr bool all_bases_named = []<std::size_t... I>(std::index_sequence<I...>) {
+        return (base_named<I>() && ...);
+    }(std::make_index_sequence<sizeof...(E)>());
+
+    static constexpr int count(bool positive) {
+        int n = 0;
+        for (int e : exps) {
+            n += e != 0 && (e > 0) == positive;
+        }
+        return n;
+    }
+
+    template <std::size_t... I>
+    static constexpr void put_factors(text_sink& sink, bool positive, bool signs, std::index_sequence<I...>) {
+        bool first = true;
+        auto factor = [&](int e, std::string_view symbol) {
+            if (e == 0 || (e > 0) != positive) {
+                return;
+            }
+            if (!first) {
+                sink.put("·");
+            }
+            first = false;
+            sink.put(symbol);
+            if (signs && e < 0) {
+                sink.put("⁻");
+            }
+            if (signs || (e != 1 && e != -1)) {
+                put_superscript(sink, e < 0 ? -e : e);
+            }
+        };
+        (factor(exps[I], base_symbol<I>()), ...);
+    }
+
+    static constexpr void write(text_sink& sink) {
+        constexpr auto indices = std::make_index_sequence<sizeof...(E)>();
+        constexpr int numerator = count(true);
+        constexpr int denominator = count(false);
+
+        if constexpr (numerator == 0) {
+            put_factors(sink, false, true, indices);
+        } else {
+            put_factors(sink, true, false, indices);
+        }
+        if constexpr (numerator > 0 && denominator > 0) {
+            sink.put("/");
+            if constexpr (denominator > 1) {
+                sink.put("(");
+            }
+            put_factors(sink, false, false, indices);
+            if constexpr (denominator > 1) {
+                sink.put(")");
+            }
+        }
+    }
+};
+
+} // namespace detail
+
+// A dimension without a symbol of its own is printed with a symbol composed
+// from its base dimensions, once every base dimension it uses is named
+template <int... E>
+requires (!detail::composite_symbol_writer<E...>::is_base) && detail::composite_symbol_writer<E...>::all_bases_named
+struct unit_symbol<dim<E...>>
+{
+    static constexpr auto value = detail::static_text<detail::composite_symbol_writer<E...>>::chars.data();
+    static constexpr bool composite = true;
+};
+
+namespace ops
+{
+
+template <int... A, int... B>
+struct mul<dim<A...>, dim<B...>> { using type = typename detail::combine_dims<dim<A...>, dim<B...>, 1>::type; };
+
+template <int... A, int... B>
+struct div<dim<A...>, dim<B...>> { using type = typename detail::combine_dims<dim<A...>, dim<B...>, -1>::type; };
+
+// Needed to disambiguate from the general div<T, T>
+template <int... A>
+struct div<dim<A...>, dim<A...>> { using type = void; };
+
+template <int... A>
+struct div<void, dim<A...>> { using type = dim<-A...>; };
+
+} // namespace ops
+
+} // namespace su
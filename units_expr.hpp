@@ -0,0 +1,222 @@
+#pragma once
+
+#include <ratio>
+#include <type_traits>
+#include "units.hpp"
+
+// Opt-in expression templates. Wrapping a unit with su::expr::lazy makes the
+// arithmetic operators build an expression tree instead of evaluating eagerly.
+// When the tree is evaluated, every scale conversion in it is folded into a
+// single constant factor on one leaf, so there are no intermediate rescalings.
+// Leaves are converted with unit_cast(u, fast_math), so the usual fast_math
+// error bound applies once per leaf.
+
+namespace su::expr
+{
+
+template <typename T>
+struct is_expression : std::false_type {};
+
+template <typename T>
+concept expression = is_expression<std::remove_cvref_t<T>>::value;
+
+template <typename T>
+concept operand = expression<T> || is_unit<std::remove_cvref_t<T>>::value || std::is_arithmetic_v<std::remove_cvref_t<T>>;
+
+struct plus_op {};
+struct minus_op {};
+struct multiplies_op {};
+struct divides_op {};
+
+namespace detail
+{
+
+// True if a value of rep Rep and scale Scale converts to Rep2 and Scale2
+// without loss, by the rule for unit's implicit conversions
+template <typename Rep, typename Scale, typename Rep2, typename Scale2>
+inline constexpr bool lossless = treat_as_floating_point<Rep2>::value ||
+    (std::ratio_divide<Scale, Scale2>::den == 1 && !treat_as_floating_point<Rep>::value);
+
+} // namespace detail
+
+// Common interface of every expression node. eval<S, C>() returns the count of
+// the expression's value in scale S, computed in rep C. An expression converts
+// implicitly where a unit of its rep and scale would, and otherwise needs
+// su::expr::eval<To>.
+template <typename Derived, typename Tag, typename Rep, typename Scale>
+struct base
+{
+    using tag = Tag;
+    using rep = Rep;
+    using scale = Scale;
+
+    template <typename Rep2, typename Scale2>
+    requires (!std::is_void_v<Tag>) && detail::lossless<Rep, Scale, Rep2, Scale2>
+    constexpr operator unit<Tag, Rep2, Scale2>() const {
+        using C = std::common_type_t<Rep, Rep2>;
+        return unit<Tag, Rep2, Scale2>(static_cast<const Derived&>(*this).template eval<Scale2, C>());
+    }
+
+    template <typename T>
+    requires std::is_void_v<Tag> && std::is_arithmetic_v<T> && detail::lossless<Rep, Scale, T, std::ratio<1>>
+    constexpr operator T() const {
+        using C = std::common_type_t<Rep, T>;
+        return T(static_cast<const Derived&>(*this).template eval<std::ratio<1>, C>());
+    }
+};
+
+template <typename U>
+struct leaf : base<leaf<U>, typename U::tag, typename U::rep, typename U::scale>
+{
+    U u;
+
+    constexpr explicit leaf(const U& u) : u(u) {}
+
+    template <typename S, typename C>
+    constexpr C eval() const {
+        return su::unit_cast<unit<typename U::tag, C, S>>(u, fast_math).count();
+    }
+};
+
+namespace detail
+{
+
+template <typename Op, typename L, typename R>
+struct node_traits {};
+
+template <typename L, typename R>
+requires std::same_as<typename L::tag, typename R::tag>
+struct node_traits<plus_op, L, R>
+{
+    using tag = typename L::tag;
+    using scale = typename std::common_type_t<unit<tag, int, typename L::scale>, unit<tag, int, typename R::scale>>::scale;
+};
+
+template <typename L, typename R>
+requires std::same_as<typename L::tag, typename R::tag>
+struct node_traits<minus_op, L, R> : node_traits<plus_op, L, R> {};
+
+template <typename L, typename R>
+requires requires { typename ops::mul<typename L::tag, typename R::tag>::type; }
+struct node_traits<multiplies_op, L, R>
+{
+    using tag = typename ops::mul<typename L::tag, typename R::tag>::type;
+    using scale = std::ratio_multiply<typename L::scale, typename R::scale>;
+};
+
+template <typename L, typename R>
+requires requires { typename ops::div<typename L::tag, typename R::tag>::type; }
+struct node_traits<divides_op, L, R>
+{
+    using tag = typename ops::div<typename L::tag, typename R::tag>::type;
+    using scale = std::ratio_divide<typename L::scale, typename R::scale>;
+};
+
+} // namespace detail
+
+template <typename Op, typename L, typename R>
+struct node : base<node<Op, L, R>, typename detail::node_traits<Op, L, R>::tag,
+    std::common_type_t<typename L::rep, typename R::rep>, typename detail::node_traits<Op, L, R>::scale>
+{
+    L l;
+    R r;
+
+    constexpr node(const L& l, const R& r) : l(l), r(r) {}
+
+    // The target scale is pushed down into one operand of each product or
+    // quotient, so it ends up as a single factor on one leaf
+    template <typename S, typename C>
+    constexpr C eval() const {
+        if constexpr (std::is_same_v<Op, plus_op>) {
+            return l.template eval<S, C>() + r.template eval<S, C>();
+        } else if constexpr (std::is_same_v<Op, minus_op>) {
+            return l.template eval<S, C>() - r.template eval<S, C>();
+        } else if constexpr (std::is_same_v<Op, multiplies_op>) {
+            using SL = typename L::scale;
+            return l.template eval<SL, C>() * r.template eval<std::ratio_divide<S, SL>, C>();
+        } else {
+            using SR = typename R::scale;
+            return l.template eval<std::ratio_multiply<S, SR>, C>() / r.template eval<SR, C>();
+        }
+    }
+};
+
+template <typename U>
+struct is_expression<leaf<U>> : std::true_type {};
+
+template <typename Op, typename L, typename R>
+struct is_expression<node<Op, L, R>> : std::true_type {};
+
+// Starts an expression from a unit
+template <typename Tag, typename Rep, typename Scale>
+constexpr leaf<unit<Tag, Rep, Scale>> lazy(const unit<Tag, Rep, Scale>& u) {
+    return leaf<unit<Tag, Rep, Scale>>(u);
+}
+
+template <operand T>
+constexpr auto as_expression(const T& v) {
+    if constexpr (expression<T>) {
+        return v;
+    } else if constexpr (is_unit<T>::value) {
+        return lazy(v);
+    } else {
+        return lazy(quantity<T, std::ratio<1>>(v));
+    }
+}
+
+template <typename Op, typename A, typename B>
+using node_for = node<Op, decltype(as_expression(std::declval<A>())), decltype(as_expression(std::declval<B>()))>;
+
+template <typename Op, typename A, typename B>
+concept valid_node = requires { typename detail::node_traits<Op, decltype(as_expression(std::declval<A>())), decltype(as_expression(std::declval<B>()))>::tag; };
+
+// Evaluates an expression into its natural unit, or a plain number if the tags cancel
+template <expression E>
+constexpr auto eval(const E& e) {
+    using C = typename E::rep;
+    if constexpr (std::is_void_v<typename E::tag>) {
+        return e.template eval<std::ratio<1>, C>();
+    } else {
+        return unit<typename E::tag, C, typename E::scale>(e.template eval<typename E::scale, C>());
+    }
+}
+
+// Evaluates an expression into To. Where that loses nothing, the conversion
+// is folded into the leaves. Otherwise the expression is evaluated into its
+// natural unit and converted with unit_cast, so that each leaf is not rounded
+// on its own.
+template <typename To, expression E>
+requires std::same_as<typename To::tag, typename E::tag>
+constexpr To eval(const E& e) {
+    if constexpr (detail::lossless<typename E::rep, typename E::scale, typename To::rep, typename To::scale>) {
+        return To(e.template eval<typename To::scale, std::common_type_t<typename E::rep, typename To::rep>>());
+    } else {
+        return unit_cast<To>(eval(e));
+    }
+}
+
+template <operand A, operand B>
+requires (expression<A> || expression<B>) && valid_node<plus_op, A, B>
+constexpr auto operator+(const A& a, const B& b) {
+    return node_for<plus_op, A, B>(as_expression(a), as_expression(b));
+}
+
+template <operand A, operand B>
+requires (expression<A> || expression<B>) && valid_node<minus_op, A, B>
+constexpr auto operator-(const A& a, const B& b) {
+    return node_for<minus_op, A, B>(as_expression(a), as_expression(b));
+}
+
+template <operand A, operand B>
+requires (expression<A> || expression<B>) && valid_node<multiplies_op, A, B>
+constexpr auto operator*(const A& a, const B& b) {
+    return node_for<multiplies_op, A, B>(as_expression(a), as_expression(b));
+}
+
+template <operand A, operand B>
+requires (expression<A> || expression<B>) && valid_node<divides_op, A, B>
+constexpr auto operator/(const A& a, const B& b) {
+    return node_for<divides_op, A, B>(as_expression(a), as_expression(b));
+}
+
+} // namespace su::expr
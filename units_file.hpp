@@ -0,0 +1,499 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "units_bulk.hpp"
+#include "units_id.hpp"
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SU_SERIES_MMAP 1
+#endif
+
+// A self-describing columnar file format for series of units, which can be
+// loaded without parsing or copying. A file is a header, a descriptor of each
+// column, then the raw reps of each column, aligned to 64 bytes:
+//
+//   offset 0     series_file_header
+//   offset 64    series_column_header for each column
+//   ...          each column's reps in native byte order, at a multiple of 64
+//
+// series_file maps the file into memory and checks every descriptor when it is
+// opened. view<U> then returns the column as a span of U without copying, if
+// its symbol, rep and scale are exactly those of U. read<U> also converts a
+// column with a different scale, in a single pass over the data.
+
+namespace su
+{
+
+enum class file_errc
+{
+    ok = 0,
+    io_error,          // The file could not be opened, read or written
+    not_a_series_file, // The file does not start with the series magic
+    unsupported,       // The file has another version or byte order
+    corrupt,           // A descriptor is malformed or a column is outside the file
+    invalid_column,    // A column to write has a name or symbol that is too long, or a repeated name
+    no_such_column,    // No column has the requested name
+    wrong_symbol,      // The column's symbol is not the unit's
+    wrong_rep,         // The column's rep is not the unit's
+    wrong_scale,       // The column's scale is not the unit's, or cannot be converted to it
+    out_of_range,      // A value does not fit in the unit's rep after conversion
+    buffer_too_small   // The output is shorter than the column
+};
+
+constexpr std::string_view file_error_message(file_errc ec) {
+    switch (ec) {
+        case file_errc::ok: return "ok";
+        case file_errc::io_error: return "the file could not be opened, read or written";
+        case file_errc::not_a_series_file: return "not a series file";
+        case file_errc::unsupported: return "unsupported version or byte order";
+        case file_errc::corrupt: return "corrupt series file";
+        case file_errc::invalid_column: return "column name or symbol too long, or name repeated";
+        case file_errc::no_such_column: return "no such column";
+        case file_errc::wrong_symbol: return "column has another symbol";
+        case file_errc::wrong_rep: return "column has another rep";
+        case file_errc::wrong_scale: return "column has another scale";
+        case file_errc::out_of_range: return "value out of range";
+        case file_errc::buffer_too_small: return "output shorter than column";
+    }
+    return "unknown error";
+}
+
+struct series_file_header
+{
+    char magic[8];   // "SUSERIES"
+    uint32_t version;
+    uint32_t byte_order; // 0x01020304 as written by the producer
+    uint64_t column_count;
+    char reserved[40];
+};
+
+struct series_column_header
+{
+    char name[32];   // Null terminated
+    char symbol[32]; // Null terminated
+    uint64_t type_id;
+    uint64_t offset; // From the start of the file
+    uint64_t count;
+    int64_t num;
+    int64_t den;
+    uint8_t kind;    // rep_kind
+    uint8_t rep_size;
+    char reserved[22];
+};
+
+static_assert(sizeof(series_file_header) == 64 && sizeof(series_column_header) == 128);
+
+inline constexpr char series_magic[8] = {'S', 'U', 'S', 'E', 'R', 'I', 'E', 'S'};
+inline constexpr uint32_t series_version = 1;
+inline constexpr uint32_t series_byte_order = 0x01020304;
+inline constexpr std::size_t series_alignment = 64;
+
+// A column to write. The type comes from the units, and name is how readers
+// find the column again.
+struct series_column
+{
+    std::string_view name;
+    const unit_type_info* type;
+    const void* data;
+    std::size_t count;
+};
+
+template <typename U, std::size_t E>
+requires detail::identifiable<std::remove_const_t<U>>
+series_column make_series_column(std::string_view name, std::span<U, E> values) {
+    return {name, &type_info_of<std::remove_const_t<U>>, values.data(), values.size()};
+}
+
+namespace detail
+{
+
+constexpr std::size_t align_series(std::size_t n) {
+    return (n + series_alignment - 1) / series_alignment * series_alignment;
+}
+
+template <std::size_t N>
+bool copy_name(char (&out)[N], std::string_view s) {
+    if (s.size() >= N) {
+        return false;
+    }
+    std::memcpy(out, s.data(), s.size());
+    return true;
+}
+
+// A null-terminated name within a descriptor in the mapped file
+inline std::string_view read_name(const std::byte* descriptor, std::size_t offset) {
+    return reinterpret_cast<const char*>(descriptor + offset);
+}
+
+} // namespace detail
+
+// Writes columns to a new file at path, replacing any existing file
+inline file_errc write_series(const std::filesystem::path& path, std::span<const series_column> columns) {
+    series_file_header header{};
+    std::memcpy(header.magic, series_magic, sizeof(series_magic));
+    header.version = series_version;
+    header.byte_order = series_byte_order;
+    header.column_count = columns.size();
+
+    std::vector<series_column_header> descriptors(columns.size());
+    std::size_t offset = detail::align_series(sizeof(header) + columns.size() * sizeof(series_column_header));
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+        const series_column& c = columns[i];
+        series_column_header& d = descriptors[i];
+        for (std::size_t j = 0; j < i; ++j) {
+            if (columns[j].name == c.name) {
+                return file_errc::invalid_column;
+            }
+        }
+        if (!detail::copy_name(d.name, c.name) || !detail::copy_name(d.symbol, c.type->symbol)) {
+            return file_errc::invalid_column;
+        }
+        d.type_id = c.type->id;
+        d.offset = offset;
+        d.count = c.count;
+        d.num = c.type->num;
+        d.den = c.type->den;
+        d.kind = static_cast<uint8_t>(c.type->kind);
+        d.rep_size = c.type->rep_size;
+        offset = detail::align_series(offset + c.count * c.type->rep_size);
+    }
+
+    std::FILE* f = std::fopen(path.string().c_str(), "wb");
+    if (!f) {
+        return file_errc::io_error;
+    }
+    static constexpr char padding[series_alignment] = {};
+    std::size_t written = 0;
+    auto put = [&](const void* p, std::size_t n) {
+        if (n != 0 && std::fwrite(p, 1, n, f) != n) {
+            return false;
+        }
+        written += n;
+        return true;
+    };
+    auto pad = [&] { return put(padding, detail::align_series(written) - written); };
+
+    bool ok = put(&header, sizeof(header)) && put(descriptors.data(), descriptors.size() * sizeof(series_column_header)) && pad();
+    for (std::size_t i = 0; ok && i < columns.size(); ++i) {
+        ok = put(columns[i].data, columns[i].count * columns[i].type->rep_size) && pad();
+    }
+    return std::fclose(f) == 0 && ok ? file_errc::ok : file_errc::io_error;
+}
+
+// The description of a column in an open file
+struct series_column_info
+{
+    std::string_view name;
+    std::string_view symbol;
+    rep_kind kind;
+    uint8_t rep_size;
+    intmax_t num;
+    intmax_t den;
+    std::size_t count;
+    const std::byte* data;
+};
+
+template <typename U>
+struct series_view_result
+{
+    std::span<const U> values;
+    file_errc ec;
+};
+
+struct series_read_result
+{
+    std::size_t count;
+    file_errc ec;
+
+    friend bool operator==(const series_read_result&, const series_read_result&) = default;
+};
+
+namespace detail
+{
+
+// The ratio std::ratio_divide<To, From> for scales known only at run time, as
+// num / den, or false if it overflows. Every part is positive.
+inline bool runtime_ratio(intmax_t from_num, intmax_t from_den, intmax_t to_num, intmax_t to_den, intmax_t& num, intmax_t& den) {
+    intmax_t g1 = std::gcd(to_num, from_num);
+    intmax_t g2 = std::gcd(from_den, to_den);
+    auto mul = [](intmax_t a, intmax_t b, intmax_t& out) {
+        if (a > std::numeric_limits<intmax_t>::max() / b) {
+            return false;
+        }
+        out = a * b;
+        return true;
+    };
+    return mul(to_num / g1, from_den / g2, num) && mul(to_den / g2, from_num / g1, den);
+}
+
+// Rescales in to out as unit_cast does, with the ratio known only at run time.
+// The loops have no branches on the data, so the compiler can vectorize them.
+template <typename Rep>
+file_errc rescale(const Rep* in, Rep* out, std::size_t n, intmax_t num, intmax_t den) {
+    if constexpr (std::is_floating_point_v<Rep>) {
+        // unit_cast computes (v * R::den) / R::num in the rep
+        Rep d = Rep(den);
+        Rep m = Rep(num);
+        for (std::size_t i = 0; i < n; ++i) {
+            out[i] = (in[i] * d) / m;
+        }
+        return file_errc::ok;
+    } else {
+        // Only whole multiples are exact. A column that would have to be
+        // divided is rejected rather than rounded.
+        if (num != 1 || std::cmp_greater(den, std::numeric_limits<Rep>::max())) {
+            return file_errc::wrong_scale;
+        }
+        using U = std::make_unsigned_t<Rep>;
+        Rep hi = std::numeric_limits<Rep>::max() / Rep(den);
+        Rep lo = std::numeric_limits<Rep>::min() / Rep(den);
+        bool fits = true;
+        for (std::size_t i = 0; i < n; ++i) {
+            fits &= in[i] >= lo && in[i] <= hi;
+            out[i] = Rep(U(in[i]) * U(den));
+        }
+        return fits ? file_errc::ok : file_errc::out_of_range;
+    }
+}
+
+} // namespace detail
+
+// A series file mapped into memory, or read into memory where there is no
+// mmap. Views of its columns are valid as long as it is open.
+class series_file
+{
+public:
+    series_file() = default;
+    series_file(const series_file&) = delete;
+    series_file& operator=(const series_file&) = delete;
+
+    series_file(series_file&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    series_file& operator=(series_file&& other) noexcept {
+        if (this != &other) {
+            close();
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+            m_columns = std::move(other.m_columns);
+#if !defined(SU_SERIES_MMAP)
+            m_buffer = std::move(other.m_buffer);
+#endif
+        }
+        return *this;
+    }
+
+    ~series_file() {
+        close();
+    }
+
+    file_errc open(const std::filesystem::path& path) {
+        close();
+        if (file_errc ec = map(path); ec != file_errc::ok) {
+            close();
+            return ec;
+        }
+        if (file_errc ec = check(); ec != file_errc::ok) {
+            close();
+            return ec;
+        }
+        return file_errc::ok;
+    }
+
+    void close() {
+#if defined(SU_SERIES_MMAP)
+        if (m_data) {
+            munmap(const_cast<std::byte*>(m_data), m_size);
+        }
+#else
+        m_buffer.clear();
+#endif
+        m_data = nullptr;
+        m_size = 0;
+        m_columns.clear();
+    }
+
+    std::span<const series_column_info> columns() const {
+        return m_columns;
+    }
+
+    const series_column_info* find(std::string_view name) const {
+        for (const auto& c : m_columns) {
+            if (c.name == name) {
+                return &c;
+            }
+        }
+        return nullptr;
+    }
+
+    // The column called name as units, without copying. Fails unless the
+    // column has exactly U's symbol, rep and scale.
+    template <typename U>
+    requires detail::identifiable<U>
+    series_view_result<U> view(std::string_view name) const {
+        const series_column_info* c = nullptr;
+        if (file_errc ec = match<U>(name, c); ec != file_errc::ok) {
+            return {{}, ec};
+        }
+        if (c->num != U::scale::num || c->den != U::scale::den) {
+            return {{}, file_errc::wrong_scale};
+        }
+        static_assert(detail::check_rep_layout<U>());
+        return {std::span<const U>(reinterpret_cast<const U*>(c->data), c->count), file_errc::ok};
+    }
+
+    // Copies the column called name into out, converting it to U's scale as
+    // unit_cast would. Integer columns are only converted to a finer scale,
+    // e.g. ms to μs, since coarser scales would round. On out_of_range, out
+    // holds wrapped values.
+    template <typename U, std::size_t E>
+    requires detail::identifiable<U>
+    series_read_result read(std::string_view name, std::span<U, E> out) const {
+        using Rep = typename U::rep;
+        const series_column_info* c = nullptr;
+        if (file_errc ec = match<U>(name, c); ec != file_errc::ok) {
+            return {0, ec};
+        }
+        if (out.size() < c->count) {
+            return {0, file_errc::buffer_too_small};
+        }
+        static_assert(detail::check_rep_layout<U>());
+        const Rep* in = reinterpret_cast<const Rep*>(c->data);
+        Rep* reps = reinterpret_cast<Rep*>(out.data());
+        if (c->num == U::scale::num && c->den == U::scale::den) {
+            std::copy_n(in, c->count, reps);
+            return {c->count, file_errc::ok};
+        }
+        intmax_t num, den;
+        if (!detail::runtime_ratio(c->num, c->den, U::scale::num, U::scale::den, num, den)) {
+            return {0, file_errc::wrong_scale};
+        }
+        file_errc ec = detail::rescale(in, reps, c->count, num, den);
+        return {ec == file_errc::wrong_scale ? 0 : c->count, ec};
+    }
+
+private:
+    template <typename U>
+    file_errc match(std::string_view name, const series_column_info*& c) const {
+        c = find(name);
+        if (!c) {
+            return file_errc::no_such_column;
+        }
+        const unit_type_info& t = type_info_of<U>;
+        if (c->symbol != t.symbol) {
+            return file_errc::wrong_symbol;
+        }
+        if (c->kind != t.kind || c->rep_size != t.rep_size) {
+            return file_errc::wrong_rep;
+        }
+        return file_errc::ok;
+    }
+
+    file_errc map(const std::filesystem::path& path) {
+#if defined(SU_SERIES_MMAP)
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return file_errc::io_error;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return file_errc::io_error;
+        }
+        m_size = std::size_t(st.st_size);
+        if (m_size < sizeof(series_file_header)) {
+            ::close(fd);
+            return file_errc::not_a_series_file;
+        }
+        void* p = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            m_size = 0;
+            return file_errc::io_error;
+        }
+        m_data = static_cast<const std::byte*>(p);
+#else
+        std::FILE* f = std::fopen(path.string().c_str(), "rb");
+        if (!f) {
+            return file_errc::io_error;
+        }
+        std::error_code ec;
+        m_size = std::filesystem::file_size(path, ec);
+        if (ec) {
+            std::fclose(f);
+            return file_errc::io_error;
+        }
+        // Blocks of 64 bytes keep every column aligned
+        m_buffer.resize(detail::align_series(m_size) / series_alignment);
+        bool ok = std::fread(m_buffer.data(), 1, m_size, f) == m_size;
+        std::fclose(f);
+        if (!ok) {
+            return file_errc::io_error;
+        }
+        m_data = reinterpret_cast<const std::byte*>(m_buffer.data());
+        if (m_size < sizeof(series_file_header)) {
+            return file_errc::not_a_series_file;
+        }
+#endif
+        return file_errc::ok;
+    }
+
+    file_errc check() {
+        series_file_header header;
+        std::memcpy(&header, m_data, sizeof(header));
+        if (std::memcmp(header.magic, series_magic, sizeof(series_magic)) != 0) {
+            return file_errc::not_a_series_file;
+        }
+        if (header.version != series_version || header.byte_order != series_byte_order) {
+            return file_errc::unsupported;
+        }
+        if (header.column_count > (m_size - sizeof(header)) / sizeof(series_column_header)) {
+            return file_errc::corrupt;
+        }
+
+        m_columns.reserve(header.column_count);
+        for (uint64_t i = 0; i < header.column_count; ++i) {
+            const std::byte* p = m_data + sizeof(header) + i * sizeof(series_column_header);
+            series_column_header d;
+            std::memcpy(&d, p, sizeof(d));
+            bool terminated = std::memchr(d.name, 0, sizeof(d.name)) && std::memchr(d.symbol, 0, sizeof(d.symbol));
+            bool known_rep = d.kind <= static_cast<uint8_t>(rep_kind::floating_point) && std::has_single_bit(d.rep_size) &&
+                d.rep_size <= 16;
+            if (!terminated || !known_rep || d.num <= 0 || d.den <= 0 || d.offset % series_alignment != 0 ||
+                d.offset > m_size || d.count > (m_size - d.offset) / d.rep_size) {
+                return file_errc::corrupt;
+            }
+            m_columns.push_back({detail::read_name(p, offsetof(series_column_header, name)),
+                detail::read_name(p, offsetof(series_column_header, symbol)), static_cast<rep_kind>(d.kind),
+                d.rep_size, d.num, d.den, d.count, m_data + d.offset});
+        }
+        return file_errc::ok;
+    }
+
+    const std::byte* m_data = nullptr;
+    std::size_t m_size = 0;
+    std::vector<series_column_info> m_columns;
+#if !defined(SU_SERIES_MMAP)
+    struct alignas(series_alignment) block { std::byte bytes[series_alignment]; };
+    std::vector<block> m_buffer;
+#endif
+};
+
+} // namespace su
@@ -0,0 +1,651 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <string_view>
+#include <system_error>
+#include "units.hpp"
+
+#if __has_include(<format>)
+#include <format>
+#endif
+
+// Allocation-free formatting and parsing of units. su::to_chars writes the
+// count with std::to_chars followed by su::unit_suffix, the prefix and symbol
+// joined into a single string at compile time. The std::formatter (when
+// the standard library provides <format>) and fmt::formatter (when
+// <fmt/format.h> is included first) specializations are built on it.
+// su::from_chars reads the same text back, including a prefix other than the
+// unit's own, and converts it to the unit's scale.
+
+namespace su
+{
+
+namespace detail
+{
+
+inline std::to_chars_result append(std::to_chars_result r, char* last, std::string_view str) {
+    if (r.ec != std::errc() || std::size_t(last - r.ptr) < str.size()) {
+        return {last, std::errc::value_too_large};
+    }
+    std::memcpy(r.ptr, str.data(), str.size());
+    return {r.ptr + str.size(), std::errc()};
+}
+
+} // namespace detail
+
+// Writes the same text as operator<< into [first, last). On failure returns
+// {last, std::errc::value_too_large}, as std::to_chars does.
+template <typename Tag, typename Rep, typename Scale>
+requires has_symbol<Tag>
+std::to_chars_result to_chars(char* first, char* last, const unit<Tag, Rep, Scale>& u) {
+    return detail::append(std::to_chars(first, last, u.count()), last, unit_suffix<Tag, Scale>);
+}
+
+template <typename Tag, typename Rep, typename Scale>
+requires has_symbol<Tag> && std::is_floating_point_v<Rep>
+std::to_chars_result to_chars(char* first, char* last, const unit<Tag, Rep, Scale>& u, std::chars_format fmt) {
+    return detail::append(std::to_chars(first, last, u.count(), fmt), last, unit_suffix<Tag, Scale>);
+}
+
+template <typename Tag, typename Rep, typename Scale>
+requires has_symbol<Tag> && std::is_floating_point_v<Rep>
+std::to_chars_result to_chars(char* first, char* last, const unit<Tag, Rep, Scale>& u, std::chars_format fmt, int precision) {
+    return detail::append(std::to_chars(first, last, u.count(), fmt, precision), last, unit_suffix<Tag, Scale>);
+}
+
+enum class parse_errc
+{
+    ok = 0,
+    invalid_number, // No number at the start of the input
+    missing_symbol, // The number is not followed by a symbol
+    wrong_symbol,   // The symbol is not the unit's, or is followed by more of a word
+    unknown_prefix, // The unit's symbol has a prefix that is not recognised
+    out_of_range,   // The value does not fit in the unit's rep
+    inexact         // The value is not a whole number of the unit's scale, for integer reps
+};
+
+constexpr std::string_view parse_error_message(parse_errc ec) {
+    switch (ec) {
+        case parse_errc::ok: return "ok";
+        case parse_errc::invalid_number: return "expected a number";
+        case parse_errc::missing_symbol: return "expected a unit symbol after the number";
+        case parse_errc::wrong_symbol: return "unit symbol does not match";
+        case parse_errc::unknown_prefix: return "unknown prefix before unit symbol";
+        case parse_errc::out_of_range: return "value out of range";
+        case parse_errc::inexact: return "value cannot be represented exactly";
+    }
+    return "unknown error";
+}
+
+// On success ptr is one past the symbol, otherwise it is where the error was
+// found: the start of the number or the start of the prefix and symbol.
+struct from_chars_result
+{
+    const char* ptr;
+    parse_errc ec;
+
+    friend bool operator==(const from_chars_result&, const from_chars_result&) = default;
+};
+
+struct bulk_from_chars_result
+{
+    const char* ptr;
+    parse_errc ec;
+    std::size_t count;
+
+    friend bool operator==(const bulk_from_chars_result&, const bulk_from_chars_result&) = default;
+};
+
+namespace detail
+{
+
+struct parsed_scale
+{
+    intmax_t num;
+    intmax_t den;
+};
+
+struct named_prefix
+{
+    std::string_view text;
+    parsed_scale scale;
+};
+
+inline constexpr named_prefix parse_prefixes[] = {
+    {"", {1, 1}}, {"E", {std::exa::num, 1}}, {"P", {std::peta::num, 1}}, {"T", {std::tera::num, 1}},
+    {"G", {std::giga::num, 1}}, {"M", {std::mega::num, 1}}, {"k", {std::kilo::num, 1}},
+    {"m", {1, std::milli::den}}, {"μ", {1, std::micro::den}}, {"u", {1, std::micro::den}},
+    {"n", {1, std::nano::den}}, {"p", {1, std::pico::den}}, {"f", {1, std::femto::den}},
+    {"a", {1, std::atto::den}},
+};
+
+// a * b for non-negative a and b, or false if it overflows
+template <typename T>
+constexpr bool checked_mul(T& a, T b) {
+    if (b != 0 && a > std::numeric_limits<T>::max() / b) {
+        return false;
+    }
+    a *= b;
+    return true;
+}
+
+// A positive ratio num / den that is kept reduced as it is built up. If
+// either part overflows, that is recorded instead of wrapping.
+struct exact_ratio
+{
+    intmax_t num = 1;
+    intmax_t den = 1;
+    bool too_large = false;
+    bool too_small = false;
+
+    constexpr bool overflow() const {
+        return too_large || too_small;
+    }
+
+    constexpr void multiply(intmax_t n, intmax_t d) {
+        intmax_t g1 = gcd(n, den);
+        intmax_t g2 = gcd(d, num);
+        den /= g1;
+        num /= g2;
+        too_large = too_large || !checked_mul(num, n / g1);
+        too_small = too_small || !checked_mul(den, d / g2);
+    }
+};
+
+// The index in parse_prefixes of the prefix starting with each byte, or 0.
+// No two prefixes start with the same byte.
+inline constexpr auto prefix_by_first_byte = [] {
+    std::array<unsigned char, 256> index{};
+    for (std::size_t i = 1; i < std::size(parse_prefixes); ++i) {
+        index[static_cast<unsigned char>(parse_prefixes[i].text[0])] = static_cast<unsigned char>(i);
+    }
+    return index;
+}();
+
+// The ratio from a parsed scale to Scale
+template <typename Scale>
+constexpr exact_ratio ratio_to(parsed_scale from) {
+    exact_ratio r;
+    r.multiply(from.num, from.den);
+    r.multiply(Scale::den, Scale::num);
+    return r;
+}
+
+// ratio_to for each of parse_prefixes, so that it is not computed per value
+template <typename Scale>
+inline constexpr auto prefix_ratios = [] {
+    std::array<exact_ratio, std::size(parse_prefixes)> ratios{};
+    for (std::size_t i = 0; i < ratios.size(); ++i) {
+        ratios[i] = ratio_to<Scale>(parse_prefixes[i].scale);
+    }
+    return ratios;
+}();
+
+// The prefix reported by parse_suffix for a bracketed scale
+inline constexpr std::size_t bracket_prefix = std::size(parse_prefixes);
+
+template <typename Scale>
+constexpr exact_ratio ratio_to(std::size_t prefix, parsed_scale bracket) {
+    return prefix == bracket_prefix ? ratio_to<Scale>(bracket) : prefix_ratios<Scale>[prefix];
+}
+
+constexpr bool is_word_char(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' ||
+        static_cast<unsigned char>(c) >= 0x80;
+}
+
+// Parses "[num]" or "[num/den]" as written by operator<< for non-SI scales
+inline const char* parse_bracket_scale(const char* first, const char* last, parsed_scale& scale) {
+    auto r = std::from_chars(first + 1, last, scale.num);
+    if (r.ec != std::errc() || scale.num <= 0) {
+        return nullptr;
+    }
+    scale.den = 1;
+    if (r.ptr != last && *r.ptr == '/') {
+        r = std::from_chars(r.ptr + 1, last, scale.den);
+        if (r.ec != std::errc() || scale.den <= 0) {
+            return nullptr;
+        }
+    }
+    return r.ptr != last && *r.ptr == ']' ? r.ptr + 1 : nullptr;
+}
+
+// Parses the prefix and symbol at first, and sets prefix to an index into
+// parse_prefixes, or to bracket_prefix and scale to the bracketed scale. The
+// longest match wins, so that "mm" is a millimetre rather than a metre
+// followed by an "m".
+// A composite symbol is in parentheses after a prefix, as unit_suffix writes it.
+inline from_chars_result parse_suffix(const char* first, const char* last, std::string_view symbol, bool composite,
+    std::size_t& prefix, parsed_scale& scale) {
+    std::string_view rest(first, std::size_t(last - first));
+    if (rest.empty() || rest.front() == '\n' || rest.front() == '\r') {
+        return {first, parse_errc::missing_symbol};
+    }
+
+    // The length of the symbol at the start of text, or 0 if it is not there
+    auto symbol_length = [&](std::string_view text, bool prefixed) -> std::size_t {
+        if (!prefixed || !composite) {
+            return text.starts_with(symbol) ? symbol.size() : 0;
+        }
+        bool wrapped = text.starts_with('(') && text.substr(1).starts_with(symbol) && text.substr(1 + symbol.size()).starts_with(')');
+        return wrapped ? symbol.size() + 2 : 0;
+    };
+
+    std::size_t length = 0;
+    if (rest.front() == '[') {
+        const char* end = parse_bracket_scale(first, last, scale);
+        if (end == nullptr) {
+            return {first, parse_errc::unknown_prefix};
+        }
+        rest.remove_prefix(std::size_t(end - first));
+        std::size_t n = symbol_length(rest, true);
+        if (n == 0) {
+            return {first, parse_errc::wrong_symbol};
+        }
+        length = std::size_t(end - first) + n;
+        prefix = bracket_prefix;
+    } else {
+        if (std::size_t n = symbol_length(rest, false)) {
+            prefix = 0;
+            length = n;
+        }
+        std::size_t i = prefix_by_first_byte[static_cast<unsigned char>(rest[0])];
+        std::string_view p = parse_prefixes[i].text;
+        if (i != 0 && rest.starts_with(p)) {
+            if (std::size_t n = symbol_length(rest.substr(p.size()), true)) {
+                prefix = i;
+                length = p.size() + n;
+            }
+        }
+        if (length == 0) {
+            std::size_t word = 0;
+            while (word < rest.size() && is_word_char(rest[word])) {
+                ++word;
+            }
+            bool prefixed = word > symbol.size() && rest.substr(0, word).ends_with(symbol);
+            return {first, prefixed ? parse_errc::unknown_prefix : parse_errc::wrong_symbol};
+        }
+    }
+    if (first + length != last && is_word_char(first[length])) {
+        return {first, parse_errc::wrong_symbol};
+    }
+    return {first + length, parse_errc::ok};
+}
+
+// Parses a decimal number exactly, as mantissa * 10^exponent. Zeros are
+// folded into the exponent, so only significant digits have to fit. The
+// mantissa is the magnitude, unsigned so that the lowest value of a signed
+// rep fits.
+inline from_chars_result parse_decimal(const char* first, const char* last, bool& negative, uintmax_t& mantissa, int& exponent) {
+    const char* p = first;
+    negative = p != last && *p == '-';
+    p += negative;
+    mantissa = 0;
+    exponent = 0;
+
+    int zeros = 0;
+    bool digits = false;
+    bool fraction = false;
+    for (; p != last; ++p) {
+        if (*p == '.' && !fraction) {
+            fraction = true;
+            continue;
+        }
+        if (*p < '0' || *p > '9') {
+            break;
+        }
+        digits = true;
+        if (*p == '0') {
+            ++zeros;
+        } else {
+            for (; zeros > 0; --zeros) {
+                if (!checked_mul(mantissa, uintmax_t(10))) {
+                    return {first, parse_errc::out_of_range};
+                }
+            }
+            if (!checked_mul(mantissa, uintmax_t(10)) || mantissa > std::numeric_limits<uintmax_t>::max() - uintmax_t(*p - '0')) {
+                return {first, parse_errc::out_of_range};
+            }
+            mantissa += uintmax_t(*p - '0');
+        }
+        exponent -= fraction;
+    }
+    if (!digits) {
+        return {first, parse_errc::invalid_number};
+    }
+    // Zeros after the last significant digit. Those after the point add
+    // nothing, but they were counted as negative exponent, so add them back.
+    exponent += zeros;
+
+    if (p != last && (*p == 'e' || *p == 'E') && p + 1 != last && (p[1] == '-' || (p[1] >= '0' && p[1] <= '9'))) {
+        int e = 0;
+        auto r = std::from_chars(p + 1, last, e);
+        if (r.ec != std::errc()) {
+            return {first, parse_errc::out_of_range};
+        }
+        // Anything beyond this is out of range or inexact for every scale
+        exponent += std::clamp(e, -100000, 100000);
+        p = r.ptr;
+    }
+    return {p, parse_errc::ok};
+}
+
+inline const char* skip_blanks(const char* first, const char* last) {
+    while (first != last && (*first == ' ' || *first == '\t')) {
+        ++first;
+    }
+    return first;
+}
+
+} // namespace detail
+
+// Parses a number, optional spaces, and then a prefix and the unit's symbol,
+// e.g. "2.5 kW", "500mJ", "3 uW" or "4[3/2]W", and converts it to the unit's
+// scale. As with std::from_chars, leading whitespace and '+' are not accepted.
+// u is only assigned on success.
+template <typename Tag, typename Rep, typename Scale>
+requires has_symbol<Tag> && (!std::is_void_v<Tag>)
+from_chars_result from_chars(const char* first, const char* last, unit<Tag, Rep, Scale>& u) {
+    std::string_view symbol = unit_symbol<Tag>::value;
+    std::size_t prefix = 0;
+    detail::parsed_scale bracket{1, 1};
+
+    if constexpr (std::is_floating_point_v<Rep>) {
+        Rep v;
+        auto r = std::from_chars(first, last, v);
+        if (r.ec == std::errc::result_out_of_range) {
+            return {first, parse_errc::out_of_range};
+        } else if (r.ec != std::errc()) {
+            return {first, parse_errc::invalid_number};
+        }
+
+        const char* suffix = detail::skip_blanks(r.ptr, last);
+        auto s = detail::parse_suffix(suffix, last, symbol, detail::is_composite_symbol<Tag>, prefix, bracket);
+        if (s.ec != parse_errc::ok) {
+            return s;
+        }
+
+        // Same operations as unit_cast, unless the ratio is too large to be
+        // held exactly, as between exa and atto
+        auto ratio = detail::ratio_to<Scale>(prefix, bracket);
+        if (ratio.overflow()) {
+            auto from = prefix == detail::bracket_prefix ? bracket : detail::parse_prefixes[prefix].scale;
+            v = Rep(v * ((long double)(from.num) / from.den * Scale::den / Scale::num));
+        } else if (ratio.num != 1 || ratio.den != 1) {
+            v = Rep(v * Rep(ratio.num) / Rep(ratio.den));
+        }
+        u = unit<Tag, Rep, Scale>(v);
+        return s;
+    } else {
+        bool negative;
+        uintmax_t mantissa;
+        int exponent;
+        auto r = detail::parse_decimal(first, last, negative, mantissa, exponent);
+        if (r.ec != parse_errc::ok) {
+            return r;
+        }
+
+        const char* suffix = detail::skip_blanks(r.ptr, last);
+        auto s = detail::parse_suffix(suffix, last, symbol, detail::is_composite_symbol<Tag>, prefix, bracket);
+        if (s.ec != parse_errc::ok) {
+            return s;
+        }
+
+        if (mantissa != 0) {
+            auto ratio = detail::ratio_to<Scale>(prefix, bracket);
+            for (; exponent > 0 && !ratio.overflow(); --exponent) {
+                ratio.multiply(10, 1);
+            }
+            for (; exponent < 0 && !ratio.overflow(); ++exponent) {
+                ratio.multiply(1, 10);
+            }
+
+            // A reduced denominator larger than any mantissa can never divide it
+            if (ratio.too_large) {
+                return {first, parse_errc::out_of_range};
+            } else if (ratio.too_small) {
+                return {first, parse_errc::inexact};
+            }
+            uintmax_t g = std::gcd(mantissa, uintmax_t(ratio.den));
+            mantissa /= g;
+            if (uintmax_t(ratio.den) != g) {
+                return {first, parse_errc::inexact};
+            } else if (!detail::checked_mul(mantissa, uintmax_t(ratio.num))) {
+                return {first, parse_errc::out_of_range};
+            }
+        }
+
+        // The magnitude of lowest() is computed in uintmax_t, where it does
+        // not overflow, and the negation wraps back to the value
+        using limits = std::numeric_limits<Rep>;
+        if (mantissa > (negative ? uintmax_t(0) - uintmax_t(limits::lowest()) : uintmax_t(limits::max()))) {
+            return {first, parse_errc::out_of_range};
+        }
+        u = unit<Tag, Rep, Scale>(Rep(negative ? uintmax_t(0) - mantissa : mantissa));
+        return s;
+    }
+}
+
+// Parses one value per line into out, stopping at the first error or when out
+// is full. Blank lines are skipped, and lines may start and end with spaces,
+// and end with '\r'.
+// count is the number of values written, and ptr is where parsing stopped:
+// the end of the input, the start of the next unparsed line, or the error.
+template <typename Tag, typename Rep, typename Scale, std::size_t E>
+requires has_symbol<Tag> && (!std::is_void_v<Tag>)
+bulk_from_chars_result from_chars(const char* first, const char* last, std::span<unit<Tag, Rep, Scale>, E> out) {
+    std::size_t count = 0;
+    while (first != last) {
+        const char* end = static_cast<const char*>(std::memchr(first, '\n', std::size_t(last - first)));
+        const char* next = end ? end + 1 : last;
+        end = end ? end : last;
+
+        const char* content = detail::skip_blanks(first, end);
+        if (content == end || (*content == '\r' && content + 1 == end)) {
+            first = next;
+            continue;
+        }
+        if (count == out.size()) {
+            break;
+        }
+
+        auto r = from_chars(content, end, out[count]);
+        if (r.ec != parse_errc::ok) {
+            return {r.ptr, r.ec, count};
+        }
+        const char* trailing = detail::skip_blanks(r.ptr, end);
+        if (trailing != end && !(*trailing == '\r' && trailing + 1 == end)) {
+            return {r.ptr, parse_errc::wrong_symbol, count};
+        }
+        ++count;
+        first = next;
+    }
+    return {first, parse_errc::ok, count};
+}
+
+namespace detail
+{
+
+// The largest precision the formatters accept, so that the text of any value
+// fits in a buffer on the stack
+inline constexpr int format_max_precision = 700;
+
+// The format spec shared by the std and fmt formatters:
+// [[fill]align][width][.precision][type], where align is one of < > ^, and
+// type is one of e f g a for floating point reps. The width counts the prefix
+// and symbol, and fill is a single char.
+struct format_spec
+{
+    char fill = ' ';
+    char align = '\0';
+    int width = 0;
+    int precision = -1;
+    char type = '\0';
+
+    // Parses the spec up to the closing '}', and advances first to it. Returns
+    // false if the spec is invalid.
+    template <typename Rep>
+    constexpr bool parse(const char*& first, const char* last) {
+        auto is_align = [](char c) { return c == '<' || c == '>' || c == '^'; };
+        auto parse_int = [&](int& v) {
+            v = 0;
+            while (first != last && *first >= '0' && *first <= '9') {
+                if (v > 100000) {
+                    return false;
+                }
+                v = v * 10 + (*first++ - '0');
+            }
+            return true;
+        };
+
+        if (last - first >= 2 && is_align(first[1]) && first[0] != '{' && first[0] != '}') {
+            fill = first[0];
+            align = first[1];
+            first += 2;
+        } else if (first != last && is_align(*first)) {
+            align = *first++;
+        }
+        if (!parse_int(width)) {
+            return false;
+        }
+        if (first != last && *first == '.') {
+            ++first;
+            if (!std::is_floating_point_v<Rep> || first == last || *first < '0' || *first > '9' || !parse_int(precision) ||
+                precision > format_max_precision) {
+                return false;
+            }
+        }
+        if (first != last && std::is_floating_point_v<Rep> && std::string_view("efga").find(*first) != std::string_view::npos) {
+            type = *first++;
+        } else if (first != last && !std::is_floating_point_v<Rep> && *first == 'd') {
+            type = *first++;
+        }
+        return first == last || *first == '}';
+    }
+
+    // Formats u into buffer, without padding. Returns the end of the text, or
+    // nullptr if it does not fit.
+    template <typename Tag, typename Rep, typename Scale>
+    char* write(char* first, char* last, const unit<Tag, Rep, Scale>& u) const {
+        std::to_chars_result r;
+        if constexpr (std::is_floating_point_v<Rep>) {
+            std::chars_format fmt =
+                type == 'e' ? std::chars_format::scientific :
+                type == 'f' ? std::chars_format::fixed :
+                type == 'a' ? std::chars_format::hex :
+                std::chars_format::general;
+            if (precision >= 0) {
+                r = to_chars(first, last, u, fmt, precision);
+            } else if (type != '\0') {
+                r = to_chars(first, last, u, fmt);
+            } else {
+                r = to_chars(first, last, u);
+            }
+        } else {
+            r = to_chars(first, last, u);
+        }
+        return r.ec == std::errc() ? r.ptr : nullptr;
+    }
+
+    // Copies [first, last) to out with the fill and alignment applied. Numbers
+    // are right aligned by default, as in std::format. The width is counted in
+    // code points, so that "μ" takes one column.
+    template <typename Out>
+    constexpr Out pad(const char* first, const char* last, Out out) const {
+        std::size_t size = 0;
+        for (const char* c = first; c != last; ++c) {
+            size += (static_cast<unsigned char>(*c) & 0xC0) != 0x80;
+        }
+        std::size_t padding = std::size_t(width) > size ? std::size_t(width) - size : 0;
+        std::size_t before = align == '<' ? 0 : align == '^' ? padding / 2 : padding;
+        for (std::size_t i = 0; i < before; ++i) {
+            *out++ = fill;
+        }
+        for (; first != last; ++first) {
+            *out++ = *first;
+        }
+        for (std::size_t i = before; i < padding; ++i) {
+            *out++ = fill;
+        }
+        return out;
+    }
+};
+
+// Enough for any value of Rep in any notation with a precision up to
+// format_max_precision, followed by the suffix: a sign, the integer digits of
+// the largest value in fixed notation, the point and the fraction, with room
+// to spare for the prefix and exponent of the other notations
+template <typename Rep, typename Tag, typename Scale>
+inline constexpr std::size_t format_buffer_size =
+    (std::is_floating_point_v<Rep> ? std::numeric_limits<Rep>::max_exponent10 + format_max_precision : std::numeric_limits<Rep>::digits10) +
+    32 + unit_suffix<Tag, Scale>.size();
+
+} // namespace detail
+
+} // namespace su
+
+#if defined(__cpp_lib_format)
+
+template <typename Tag, typename Rep, typename Scale>
+requires su::has_symbol<Tag>
+struct std::formatter<su::unit<Tag, Rep, Scale>, char>
+{
+    su::detail::format_spec spec;
+
+    constexpr auto parse(std::format_parse_context& ctx) {
+        const char* first = std::to_address(ctx.begin());
+        const char* end = first;
+        if (!spec.parse<Rep>(end, std::to_address(ctx.end()))) {
+            throw std::format_error("invalid format spec for su::unit");
+        }
+        return ctx.begin() + (end - first);
+    }
+
+    template <typename Context>
+    auto format(const su::unit<Tag, Rep, Scale>& u, Context& ctx) const {
+        char buffer[su::detail::format_buffer_size<Rep, Tag, Scale>];
+        char* end = spec.write(buffer, buffer + sizeof(buffer), u);
+        if (end == nullptr) {
+            throw std::format_error("su::unit too long to format");
+        }
+        return spec.pad(buffer, end, ctx.out());
+    }
+};
+
+#endif
+
+#if defined(FMT_VERSION)
+
+template <typename Tag, typename Rep, typename Scale>
+requires su::has_symbol<Tag>
+struct fmt::formatter<su::unit<Tag, Rep, Scale>, char>
+{
+    su::detail::format_spec spec;
+
+    constexpr auto parse(fmt::format_parse_context& ctx) {
+        const char* end = ctx.begin();
+        if (!spec.parse<Rep>(end, ctx.end())) {
+            throw fmt::format_error("invalid format spec for su::unit");
+        }
+        return end;
+    }
+
+    template <typename Context>
+    auto format(const su::unit<Tag, Rep, Scale>& u, Context& ctx) const {
+        char buffer[su::detail::format_buffer_size<Rep, Tag, Scale>];
+        char* end = spec.write(buffer, buffer + sizeof(buffer), u);
+        if (end == nullptr) {
+            throw fmt::format_error("su::unit too long to format");
+        }
+        return spec.pad(buffer, end, ctx.out());
+    }
+};
+
+#endif
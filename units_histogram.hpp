@@ -0,0 +1,284 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "units.hpp"
+
+// A histogram of units with log-linear buckets, as in HdrHistogram. Values
+// below 2^(Bits + 1) each have a bucket of their own. Above that, each power
+// of two is split into 2^Bits buckets of equal width, so that a bucket is never
+// wider than 2^-Bits of the values in it. The default of 7 bits keeps
+// percentiles within 0.8% of the recorded values, with 7424 buckets that
+// cover every 64-bit count.
+//
+// Recording converts the value to the histogram's unit once, finds its bucket
+// with a few shifts, and adds to the bucket's counter with a relaxed atomic
+// add, so many threads can record at once without locking. A local_histogram
+// is recorded into by one thread, with a plain load and store instead, and
+// can still be read by any thread. Queries are made on a snapshot, which
+// copies the counters, and snapshots of histograms of the same unit can be
+// merged.
+
+namespace su
+{
+
+namespace detail
+{
+
+// The bucket of v, from the position of its highest set bit and the Bits
+// bits below it. Values below 2^(Bits + 1) are their own bucket.
+template <int Bits>
+constexpr std::size_t histogram_bucket(std::uint64_t v) noexcept {
+    int shift = std::bit_width(v | (std::uint64_t(1) << Bits)) - 1 - Bits;
+    return (std::size_t(shift) << Bits) + std::size_t(v >> shift);
+}
+
+// The smallest value in a bucket
+template <int Bits>
+constexpr std::uint64_t histogram_lowest(std::size_t bucket) noexcept {
+    std::size_t shift = bucket >> Bits;
+    if (shift == 0) {
+        return bucket;
+    }
+    return std::uint64_t((bucket & ((std::size_t(1) << Bits) - 1)) | (std::size_t(1) << Bits)) << (shift - 1);
+}
+
+// The largest value in a bucket
+template <int Bits>
+constexpr std::uint64_t histogram_highest(std::size_t bucket) noexcept {
+    std::size_t shift = bucket >> Bits;
+    return histogram_lowest<Bits>(bucket) + ((std::uint64_t(1) << (shift == 0 ? 0 : shift - 1)) - 1);
+}
+
+template <int Bits>
+inline constexpr std::size_t histogram_buckets = histogram_bucket<Bits>(~std::uint64_t(0)) + 1;
+
+} // namespace detail
+
+template <typename U, int Bits, bool SingleWriter>
+class basic_histogram;
+
+// The counts of a histogram at one point in time
+template <typename U, int Bits = 7>
+class histogram_snapshot
+{
+public:
+    using value_type = U;
+
+    static constexpr std::size_t bucket_count = detail::histogram_buckets<Bits>;
+
+    histogram_snapshot() : m_counts(bucket_count) {}
+
+    std::uint64_t count() const noexcept {
+        return m_total;
+    }
+
+    // The smallest and largest values recorded. Zero if nothing was recorded.
+    U min() const noexcept {
+        return U(typename U::rep(m_total ? m_min : 0));
+    }
+
+    U max() const noexcept {
+        return U(typename U::rep(m_max));
+    }
+
+    // The value below or at which p percent of the recorded values lie, for p
+    // in [0, 100]. This is the largest value of the bucket that holds the
+    // value, so it is never less than the value and at most 2^-Bits above it.
+    U percentile(double p) const noexcept {
+        if (m_total == 0) {
+            return U::zero();
+        }
+        double rank = std::clamp(p, 0.0, 100.0) / 100 * double(m_total);
+        std::uint64_t target = std::max<std::uint64_t>(1, std::uint64_t(rank) + (double(std::uint64_t(rank)) < rank));
+        std::uint64_t seen = 0;
+        for (std::size_t b = 0; b < bucket_count; ++b) {
+            seen += m_counts[b];
+            if (seen >= target) {
+                // Not std::clamp, as a snapshot taken during a record may
+                // see the count before the extremes
+                return U(typename U::rep(std::min(std::max(detail::histogram_highest<Bits>(b), m_min), m_max)));
+            }
+        }
+        return max();
+    }
+
+    // The mean of the recorded values, taking each value as the middle of its
+    // bucket
+    unit<typename U::tag, double, typename U::scale> mean() const noexcept {
+        if (m_total == 0) {
+            return unit<typename U::tag, double, typename U::scale>(0.0);
+        }
+        double sum = 0;
+        for (std::size_t b = 0; b < bucket_count; ++b) {
+            if (m_counts[b]) {
+                double middle = (double(detail::histogram_lowest<Bits>(b)) + double(detail::histogram_highest<Bits>(b))) / 2;
+                sum += middle * double(m_counts[b]);
+            }
+        }
+        return unit<typename U::tag, double, typename U::scale>(sum / double(m_total));
+    }
+
+    // The number of values recorded in bucket b, whose values range from
+    // lowest(b) to highest(b)
+    std::uint64_t bucket(std::size_t b) const noexcept {
+        return m_counts[b];
+    }
+
+    static U lowest(std::size_t b) noexcept {
+        return U(typename U::rep(detail::histogram_lowest<Bits>(b)));
+    }
+
+    static U highest(std::size_t b) noexcept {
+        return U(typename U::rep(detail::histogram_highest<Bits>(b)));
+    }
+
+    // Adds the counts of another snapshot, e.g. of another thread's histogram
+    histogram_snapshot& operator+=(const histogram_snapshot& other) noexcept {
+        for (std::size_t b = 0; b < bucket_count; ++b) {
+            m_counts[b] += other.m_counts[b];
+        }
+        if (other.m_total) {
+            m_min = m_total ? std::min(m_min, other.m_min) : other.m_min;
+            m_max = std::max(m_max, other.m_max);
+        }
+        m_total += other.m_total;
+        return *this;
+    }
+
+private:
+    static_assert(is_unit<U>::value && std::is_integral_v<typename U::rep>, "su::histogram needs a unit with an integer rep");
+    static_assert(Bits >= 1 && Bits <= 16);
+
+    template <typename, int, bool>
+    friend class basic_histogram;
+
+    std::vector<std::uint64_t> m_counts;
+    std::uint64_t m_total = 0;
+    std::uint64_t m_min = 0;
+    std::uint64_t m_max = 0;
+};
+
+// A histogram of U, which must have an integer rep. Values of the same tag at
+// any scale are converted to U with unit_cast when they are recorded, so a
+// coarser histogram truncates finer values. Negative values are counted as
+// zero. Use su::histogram or su::local_histogram rather than this directly.
+template <typename U, int Bits, bool SingleWriter>
+class basic_histogram
+{
+public:
+    using value_type = U;
+    using snapshot_type = histogram_snapshot<U, Bits>;
+
+    static constexpr std::size_t bucket_count = snapshot_type::bucket_count;
+
+    basic_histogram() : m_counts(std::make_unique<std::atomic<std::uint64_t>[]>(bucket_count)) {}
+
+    basic_histogram(const basic_histogram&) = delete;
+    basic_histogram& operator=(const basic_histogram&) = delete;
+
+    template <typename Rep2, typename Scale2>
+    requires std::is_integral_v<Rep2>
+    void record(unit<typename U::tag, Rep2, Scale2> u, std::uint64_t n = 1) noexcept {
+        auto rep = unit_cast<U>(u).count();
+        std::uint64_t v = std::cmp_less(rep, 0) ? 0 : std::uint64_t(rep);
+        add(m_counts[detail::histogram_bucket<Bits>(v)], n);
+        lower(m_min, v);
+        raise(m_max, v);
+    }
+
+    // Copies the counts. Values recorded during the copy may or may not be
+    // included, and the counts of different buckets may be from slightly
+    // different times.
+    snapshot_type snapshot() const {
+        snapshot_type s;
+        for (std::size_t b = 0; b < bucket_count; ++b) {
+            s.m_counts[b] = m_counts[b].load(std::memory_order_relaxed);
+            s.m_total += s.m_counts[b];
+        }
+        s.m_min = m_min.load(std::memory_order_relaxed);
+        s.m_max = m_max.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    // Adds the counts of a snapshot, e.g. one taken in another process
+    void merge(const snapshot_type& s) noexcept {
+        for (std::size_t b = 0; b < bucket_count; ++b) {
+            if (s.m_counts[b]) {
+                add(m_counts[b], s.m_counts[b]);
+            }
+        }
+        if (s.m_total) {
+            lower(m_min, s.m_min);
+            raise(m_max, s.m_max);
+        }
+    }
+
+    // Sets every count to zero. Values recorded at the same time may be lost.
+    void reset() noexcept {
+        for (std::size_t b = 0; b < bucket_count; ++b) {
+            m_counts[b].store(0, std::memory_order_relaxed);
+        }
+        m_min.store(~std::uint64_t(0), std::memory_order_relaxed);
+        m_max.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    // With a single writer, a plain load and store are enough, and are much
+    // cheaper than an atomic add. Readers still see each counter whole.
+    static void add(std::atomic<std::uint64_t>& c, std::uint64_t n) noexcept {
+        if constexpr (SingleWriter) {
+            c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        } else {
+            c.fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+
+    // The extremes rarely change, so they are read before being written
+    static void lower(std::atomic<std::uint64_t>& extreme, std::uint64_t v) noexcept {
+        std::uint64_t current = extreme.load(std::memory_order_relaxed);
+        if constexpr (SingleWriter) {
+            if (v < current) {
+                extreme.store(v, std::memory_order_relaxed);
+            }
+        } else {
+            while (v < current && !extreme.compare_exchange_weak(current, v, std::memory_order_relaxed)) {
+            }
+        }
+    }
+
+    static void raise(std::atomic<std::uint64_t>& extreme, std::uint64_t v) noexcept {
+        std::uint64_t current = extreme.load(std::memory_order_relaxed);
+        if constexpr (SingleWriter) {
+            if (v > current) {
+                extreme.store(v, std::memory_order_relaxed);
+            }
+        } else {
+            while (v > current && !extreme.compare_exchange_weak(current, v, std::memory_order_relaxed)) {
+            }
+        }
+    }
+
+    std::unique_ptr<std::atomic<std::uint64_t>[]> m_counts;
+    std::atomic<std::uint64_t> m_min{~std::uint64_t(0)};
+    std::atomic<std::uint64_t> m_max{0};
+};
+
+// A histogram that any number of threads can record into at once. Each record
+// is an atomic add.
+template <typename U, int Bits = 7>
+using histogram = basic_histogram<U, Bits, false>;
+
+// A histogram that only one thread records into, or merges into, at a time.
+// Other threads can take snapshots of it at any time. Recording is a few times
+// faster than with su::histogram. A thread can keep its own local_histogram,
+// and a reader can add up their snapshots.
+template <typename U, int Bits = 7>
+using local_histogram = basic_histogram<U, Bits, true>;
+
+} // namespace su
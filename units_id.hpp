@@ -0,0 +1,269 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "units.hpp"
+
+// Ids for unit types that are the same in every build, for serialization,
+// logging and IPC. su::type_id<U> is a 64-bit hash of the tag's symbol, the
+// kind and size of the rep, and the scale, and su::type_info_of<U> describes U
+// for code that only has the id. su::type_registry maps ids back to those
+// descriptions through a perfect hash, so a lookup has no probing.
+
+namespace su
+{
+
+enum class rep_kind : std::uint8_t
+{
+    signed_integer,
+    unsigned_integer,
+    floating_point
+};
+
+struct unit_type_info
+{
+    std::uint64_t id;
+    std::string_view symbol;
+    std::string_view suffix; // The prefix and symbol printed after the count
+    rep_kind kind;
+    std::uint8_t rep_size;
+    intmax_t num;
+    intmax_t den;
+
+    friend constexpr bool operator==(const unit_type_info&, const unit_type_info&) = default;
+};
+
+namespace detail
+{
+
+constexpr std::uint64_t fnv1a(std::uint64_t h, std::string_view bytes) {
+    for (char c : bytes) {
+        h = (h ^ static_cast<unsigned char>(c)) * 0x100000001b3;
+    }
+    return h;
+}
+
+constexpr std::uint64_t fnv1a(std::uint64_t h, std::uint64_t v) {
+    for (int i = 0; i < 8; ++i) {
+        h = (h ^ ((v >> (8 * i)) & 0xFF)) * 0x100000001b3;
+    }
+    return h;
+}
+
+template <typename Rep>
+inline constexpr rep_kind rep_kind_of = std::is_floating_point_v<Rep> ? rep_kind::floating_point
+    : std::is_signed_v<Rep>                                         ? rep_kind::signed_integer
+                                                                    : rep_kind::unsigned_integer;
+
+template <typename U>
+concept identifiable = is_unit<U>::value && has_symbol<typename U::tag> && std::is_arithmetic_v<typename U::rep>;
+
+template <identifiable U>
+constexpr unit_type_info make_type_info() {
+    using Rep = typename U::rep;
+    rep_kind kind = rep_kind_of<Rep>;
+    std::string_view symbol = unit_symbol<typename U::tag>::value;
+
+    // The kind is hashed as a letter so that the byte layout of ids does not
+    // depend on the enum
+    char kind_char = "iuf"[static_cast<int>(kind)];
+    std::uint64_t h = fnv1a(0xcbf29ce484222325, symbol);
+    h = fnv1a(h, std::string_view("\0", 1));
+    h = fnv1a(h, std::string_view(&kind_char, 1));
+    h = fnv1a(h, sizeof(Rep));
+    h = fnv1a(h, std::uint64_t(U::scale::num));
+    h = fnv1a(h, std::uint64_t(U::scale::den));
+
+    return {h, symbol, unit_suffix<typename U::tag, typename U::scale>, kind, sizeof(Rep), U::scale::num, U::scale::den};
+}
+
+// The finalizer of splitmix64
+constexpr std::uint64_t mix(std::uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+// A perfect hash of a fixed set of ids, built by hash and displace. Each id
+// falls into a bucket by its hash, and each bucket has a pilot, chosen when
+// the table is built, that is mixed into the hash to move all the bucket's
+// ids to free slots.
+class perfect_hash_table
+{
+public:
+    explicit perfect_hash_table(const std::vector<const unit_type_info*>& entries) {
+        std::size_t n = entries.size();
+        m_pilots.resize(std::bit_ceil(std::max<std::size_t>(1, n / 2)));
+        m_slot_bits = std::countr_zero(2 * std::bit_ceil(std::max<std::size_t>(1, n)));
+
+        std::vector<std::vector<const unit_type_info*>> buckets(m_pilots.size());
+        for (auto* e : entries) {
+            buckets[bucket(mix(e->id))].push_back(e);
+        }
+        std::vector<std::size_t> order(buckets.size());
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+        std::stable_sort(order.begin(), order.end(), [&](auto a, auto b) { return buckets[a].size() > buckets[b].size(); });
+
+        // Placing the largest buckets first, while most slots are free, finds
+        // a pilot quickly. If one cannot be found, try more slots.
+        for (;;) {
+            m_slots.assign(std::size_t(1) << m_slot_bits, nullptr);
+            if (place(buckets, order)) {
+                return;
+            }
+            ++m_slot_bits;
+        }
+    }
+
+    const unit_type_info* find(std::uint64_t id) const noexcept {
+        std::uint64_t h = mix(id);
+        const unit_type_info* e = m_slots[slot(h, m_pilots[bucket(h)])];
+        return e && e->id == id ? e : nullptr;
+    }
+
+private:
+    std::size_t bucket(std::uint64_t h) const noexcept {
+        return (h >> 32) & (m_pilots.size() - 1);
+    }
+
+    std::size_t slot(std::uint64_t h, std::uint64_t pilot) const noexcept {
+        return ((h ^ pilot) * 0x9e3779b97f4a7c15) >> (64 - m_slot_bits);
+    }
+
+    bool place(const std::vector<std::vector<const unit_type_info*>>& buckets, const std::vector<std::size_t>& order) {
+        constexpr std::uint64_t max_tries = 1 << 16;
+        std::vector<std::size_t> taken;
+        for (std::size_t b : order) {
+            std::uint64_t pilot = 0;
+            std::uint64_t tries = 0;
+            for (; tries < max_tries; ++tries) {
+                pilot = mix(tries);
+                taken.clear();
+                for (auto* e : buckets[b]) {
+                    std::size_t s = slot(mix(e->id), pilot);
+                    if (m_slots[s] || std::find(taken.begin(), taken.end(), s) != taken.end()) {
+                        break;
+                    }
+                    taken.push_back(s);
+                }
+                if (taken.size() == buckets[b].size()) {
+                    break;
+                }
+            }
+            if (tries == max_tries) {
+                return false;
+            }
+            m_pilots[b] = pilot;
+            for (std::size_t i = 0; i < taken.size(); ++i) {
+                m_slots[taken[i]] = buckets[b][i];
+            }
+        }
+        return true;
+    }
+
+    std::vector<std::uint64_t> m_pilots;
+    std::vector<const unit_type_info*> m_slots;
+    int m_slot_bits;
+};
+
+} // namespace detail
+
+template <typename U>
+requires detail::identifiable<U>
+inline constexpr unit_type_info type_info_of = detail::make_type_info<U>();
+
+template <typename U>
+requires detail::identifiable<U>
+inline constexpr std::uint64_t type_id = type_info_of<U>.id;
+
+// Maps type ids to their descriptions. The perfect hash is rebuilt by the
+// first lookup that misses after types were added, so adding many types, e.g.
+// during static initialization, builds it once. Other lookups take no lock.
+class type_registry
+{
+public:
+    type_registry() = default;
+    type_registry(const type_registry&) = delete;
+    type_registry& operator=(const type_registry&) = delete;
+
+    static type_registry& instance() {
+        static type_registry r;
+        return r;
+    }
+
+    // Keeps a pointer to info, which must outlive the registry, as
+    // type_info_of does. Returns false if a different type with the same id
+    // was added before, in which case info is not added.
+    bool add(const unit_type_info& info) {
+        std::lock_guard lock(m_mutex);
+        auto [it, inserted] = m_entries.emplace(info.id, &info);
+        if (inserted) {
+            m_stale.store(true, std::memory_order_release);
+        }
+        return inserted || *it->second == info;
+    }
+
+    template <typename U>
+    bool add() {
+        return add(type_info_of<U>);
+    }
+
+    // The description of the type with this id, or nullptr if none was added
+    const unit_type_info* find(std::uint64_t id) const {
+        const detail::perfect_hash_table* table = m_table.load(std::memory_order_acquire);
+        const unit_type_info* e = table ? table->find(id) : nullptr;
+        if (!e && m_stale.load(std::memory_order_acquire)) {
+            e = rebuild()->find(id);
+        }
+        return e;
+    }
+
+    std::size_t size() const {
+        std::lock_guard lock(m_mutex);
+        return m_entries.size();
+    }
+
+private:
+    const detail::perfect_hash_table* rebuild() const {
+        std::lock_guard lock(m_mutex);
+        if (m_stale.load(std::memory_order_relaxed)) {
+            std::vector<const unit_type_info*> entries;
+            entries.reserve(m_entries.size());
+            for (const auto& [id, e] : m_entries) {
+                entries.push_back(e);
+            }
+            // Other readers may still be using the previous tables, so they
+            // are kept until the registry is destroyed
+            m_tables.push_back(std::make_unique<const detail::perfect_hash_table>(entries));
+            m_table.store(m_tables.back().get(), std::memory_order_release);
+            m_stale.store(false, std::memory_order_relaxed);
+        }
+        return m_table.load(std::memory_order_relaxed);
+    }
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::uint64_t, const unit_type_info*> m_entries;
+    mutable std::vector<std::unique_ptr<const detail::perfect_hash_table>> m_tables;
+    mutable std::atomic<const detail::perfect_hash_table*> m_table{nullptr};
+    mutable std::atomic<bool> m_stale{false};
+};
+
+namespace detail
+{
+
+// Adds U to the global registry during static initialization, once anything
+// refers to it
+template <typename U>
+inline const bool registered_type = type_registry::instance().add<U>();
+
+} // namespace detail
+
+} // namespace su
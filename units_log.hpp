@@ -0,0 +1,231 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "units_format.hpp"
+#include "units_id.hpp"
+
+// Deferred-formatting binary log of unit values. binlog::write copies the raw
+// bits of the count and an id of the unit type into a ring buffer owned by the
+// calling thread, without locking or formatting. binlog::drain, usually called
+// from a background thread, takes the records out of every thread's ring, and
+// binlog::decode looks the id up in su::type_registry to turn a record back
+// into text with the right prefix and symbol. When a ring is full, new records
+// are dropped and counted rather than blocking the writer.
+
+// Records per thread. Must be a power of two.
+#ifndef SU_BINLOG_RING_SIZE
+#define SU_BINLOG_RING_SIZE 65536
+#endif
+
+namespace su::binlog
+{
+
+struct record
+{
+    std::uint64_t type;
+    std::uint64_t bits;
+};
+
+namespace detail
+{
+
+template <typename U>
+concept loggable = su::detail::identifiable<U> && sizeof(typename U::rep) <= sizeof(std::uint64_t);
+
+template <typename Rep>
+std::to_chars_result format(char* first, char* last, std::uint64_t bits, std::string_view suffix) {
+    Rep v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return su::detail::append(std::to_chars(first, last, v), last, suffix);
+}
+
+// Formats bits as the first of Reps that matches the rep described by info
+template <typename... Reps>
+std::to_chars_result format_as_any(const unit_type_info& info, char* first, char* last, std::uint64_t bits) {
+    std::to_chars_result r{last, std::errc::invalid_argument};
+    auto match = [&]<typename Rep>() {
+        if (info.kind == su::detail::rep_kind_of<Rep> && info.rep_size == sizeof(Rep)) {
+            r = format<Rep>(first, last, bits, info.suffix);
+            return true;
+        }
+        return false;
+    };
+    (match.template operator()<Reps>() || ...);
+    return r;
+}
+
+// Single producer, single consumer ring of records. The producer only writes
+// m_head and the consumer only writes m_tail, each on its own cache line.
+class ring
+{
+public:
+    static constexpr std::size_t capacity = SU_BINLOG_RING_SIZE;
+    static_assert(std::has_single_bit(capacity));
+
+    bool push(const record& r) noexcept {
+        std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail_cache == capacity) {
+            m_tail_cache = m_tail.load(std::memory_order_acquire);
+            if (head - m_tail_cache == capacity) {
+                m_dropped.store(m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        m_records[head & (capacity - 1)] = r;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    template <typename F>
+    std::size_t drain(F& f) {
+        std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        std::size_t head = m_head.load(std::memory_order_acquire);
+        for (std::size_t i = tail; i != head; ++i) {
+            f(m_records[i & (capacity - 1)]);
+        }
+        m_tail.store(head, std::memory_order_release);
+        return head - tail;
+    }
+
+    std::uint64_t dropped() const noexcept {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    std::atomic<bool> in_use{false};
+
+private:
+    alignas(64) std::atomic<std::size_t> m_head{0};
+    std::size_t m_tail_cache = 0;
+    std::atomic<std::uint64_t> m_dropped{0};
+    alignas(64) std::atomic<std::size_t> m_tail{0};
+    alignas(64) record m_records[capacity];
+};
+
+// Owns every ring. A ring outlives its thread so that its last records can
+// still be drained, and is then reused by a new thread.
+class rings
+{
+public:
+    static rings& instance() {
+        static rings r;
+        return r;
+    }
+
+    ring* acquire() {
+        std::lock_guard lock(m_mutex);
+        for (auto& r : m_rings) {
+            bool expected = false;
+            if (r->in_use.compare_exchange_strong(expected, true)) {
+                return r.get();
+            }
+        }
+        m_rings.push_back(std::make_unique<ring>());
+        m_rings.back()->in_use = true;
+        return m_rings.back().get();
+    }
+
+    // f runs without m_mutex held, so that it may write or call dropped().
+    // Rings are never freed, so the pointers taken under the lock stay valid.
+    // m_drain_mutex keeps each ring to a single consumer.
+    template <typename F>
+    std::size_t drain(F& f) {
+        std::lock_guard drain_lock(m_drain_mutex);
+        std::vector<ring*> current;
+        {
+            std::lock_guard lock(m_mutex);
+            current.reserve(m_rings.size());
+            for (auto& r : m_rings) {
+                current.push_back(r.get());
+            }
+        }
+        std::size_t n = 0;
+        for (ring* r : current) {
+            n += r->drain(f);
+        }
+        return n;
+    }
+
+    std::uint64_t dropped() {
+        std::lock_guard lock(m_mutex);
+        std::uint64_t n = 0;
+        for (auto& r : m_rings) {
+            n += r->dropped();
+        }
+        return n;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::mutex m_drain_mutex;
+    std::vector<std::unique_ptr<ring>> m_rings;
+};
+
+// The calling thread's ring, which is released for reuse when the thread exits
+struct thread_ring
+{
+    ring* r = rings::instance().acquire();
+
+    ~thread_ring() {
+        r->in_use.store(false, std::memory_order_release);
+    }
+};
+
+inline ring& this_thread_ring() {
+    thread_local thread_ring t;
+    return *t.r;
+}
+
+} // namespace detail
+
+// Gives the calling thread its ring, so that its writes neither allocate nor
+// lock. Throws std::bad_alloc if the ring cannot be allocated. Calling it
+// again on the same thread does nothing.
+inline void attach() {
+    (void)detail::this_thread_ring();
+}
+
+// Logs u without formatting it. Returns false if the thread's ring was full
+// and the record was dropped. The first write of a thread that has not called
+// attach attaches it, and so may throw.
+template <typename Tag, typename Rep, typename Scale>
+requires detail::loggable<unit<Tag, Rep, Scale>>
+bool write(const unit<Tag, Rep, Scale>& u) {
+    (void)su::detail::registered_type<unit<Tag, Rep, Scale>>;
+    record r{type_id<unit<Tag, Rep, Scale>>, 0};
+    Rep v = u.count();
+    std::memcpy(&r.bits, &v, sizeof(v));
+    return detail::this_thread_ring().push(r);
+}
+
+// Calls f(const record&) for every record written so far, in order for each
+// thread, and returns how many there were. Safe to call from any thread. f may
+// write and call dropped(), but not drain.
+template <typename F>
+std::size_t drain(F&& f) {
+    return detail::rings::instance().drain(f);
+}
+
+// Writes the text of a record as su::to_chars would have. Returns
+// {last, std::errc::invalid_argument} if the record's type is not in
+// su::type_registry, to which every logged type is added.
+inline std::to_chars_result decode(const record& r, char* first, char* last) {
+    const unit_type_info* info = type_registry::instance().find(r.type);
+    if (!info) {
+        return {last, std::errc::invalid_argument};
+    }
+    return detail::format_as_any<std::int8_t, std::int16_t, std::int32_t, std::int64_t, std::uint8_t, std::uint16_t,
+        std::uint32_t, std::uint64_t, float, double>(*info, first, last, r.bits);
+}
+
+// The number of records dropped because a ring was full
+inline std::uint64_t dropped() {
+    return detail::rings::instance().dropped();
+}
+
+} // namespace su::binlog
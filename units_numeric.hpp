@@ -0,0 +1,825 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include "units_bulk.hpp"
+
+// Numeric algorithms over ranges of units, which keep the unit type through
+// the reduction.
+//
+// su::sum adds floating point units with a choice of strategy. naive is a
+// plain loop. kahan and neumaier carry a compensation term that recovers the
+// low-order bits lost by each addition, and pairwise sums halves recursively,
+// so that the error grows with log n rather than n. For contiguous ranges of
+// double reps the inner loops run in vector lanes. The vector Neumaier sum
+// uses the branch-free TwoSum in each lane, which computes the same error
+// term. Compensated sums do not survive -ffast-math, which lets the compiler
+// cancel the compensation.
+//
+// su::accumulate sums integer units in an accumulator rep wide enough that
+// the sum cannot overflow, chosen at compile time from the input rep and a
+// bound on the number of elements. su::reduce converts that sum to a given
+// result unit. Contiguous ranges of 32 and 64-bit reps are summed in vector
+// lanes, each element widened as it is added.
+//
+// su::welford_accumulator keeps the count, mean, variance and extremes of
+// units in one pass, with Welford's update for each value and Chan's formula
+// to merge accumulators, e.g. from several threads. The variance is a unit
+// of the square of the tag, which is the product declared with SU_MUL if
+// there is one, and su::squared_t<Tag> otherwise. su::statistics fills an
+// accumulator from a range. For contiguous ranges it takes blocks in vector
+// lanes, summing deviations from the mean so far, and merges each block.
+
+namespace su
+{
+
+struct naive_t { explicit naive_t() = default; };
+struct kahan_t { explicit kahan_t() = default; };
+struct neumaier_t { explicit neumaier_t() = default; };
+struct pairwise_t { explicit pairwise_t() = default; };
+
+inline constexpr naive_t naive{};
+inline constexpr kahan_t kahan{};
+inline constexpr neumaier_t neumaier{};
+inline constexpr pairwise_t pairwise{};
+
+// Kahan's compensated sum. Loses accuracy when an addend is larger than the
+// running sum, which neumaier_accumulator handles. The compensation is the
+// rounding error of the last addition only, so it is kept in the rep.
+template <typename U>
+requires is_unit<U>::value && treat_as_floating_point<typename U::rep>::value
+class kahan_accumulator
+{
+public:
+    using value_type = U;
+
+    constexpr kahan_accumulator() = default;
+    constexpr explicit kahan_accumulator(U init) : m_sum(init.count()) {}
+
+    template <typename Rep2, typename Scale2>
+    requires std::is_convertible_v<unit<typename U::tag, Rep2, Scale2>, U>
+    constexpr kahan_accumulator& operator+=(unit<typename U::tag, Rep2, Scale2> u) {
+        add(U(u).count());
+        return *this;
+    }
+
+    // Adds the sum held by another accumulator, e.g. from another thread
+    constexpr kahan_accumulator& operator+=(const kahan_accumulator& other) {
+        // Kahan's update is only exact for addends no larger than the running
+        // sum, so the larger of the two sums is kept as the running one
+        kahan_accumulator smaller = other;
+        if ((other.m_sum < 0 ? -other.m_sum : other.m_sum) > (m_sum < 0 ? -m_sum : m_sum)) {
+            std::swap(*this, smaller);
+        }
+        add(smaller.m_sum);
+        add(-smaller.m_c);
+        return *this;
+    }
+
+    constexpr U value() const { return U(m_sum - m_c); }
+
+private:
+    using Rep = typename U::rep;
+
+    constexpr void add(Rep x) {
+        Rep y = x - m_c;
+        Rep t = m_sum + y;
+        m_c = (t - m_sum) - y;
+        m_sum = t;
+    }
+
+    Rep m_sum = 0;
+    Rep m_c = 0;
+};
+
+// Neumaier's improvement of Kahan's sum, which also compensates when the
+// addend is larger than the running sum
+template <typename U>
+requires is_unit<U>::value && treat_as_floating_point<typename U::rep>::value
+class neumaier_accumulator
+{
+public:
+    using value_type = U;
+
+    constexpr neumaier_accumulator() = default;
+    constexpr explicit neumaier_accumulator(U init) : m_sum(init.count()) {}
+
+    template <typename Rep2, typename Scale2>
+    requires std::is_convertible_v<unit<typename U::tag, Rep2, Scale2>, U>
+    constexpr neumaier_accumulator& operator+=(unit<typename U::tag, Rep2, Scale2> u) {
+        add(U(u).count());
+        return *this;
+    }
+
+    // Adds the sum held by another accumulator, e.g. from another thread
+    constexpr neumaier_accumulator& operator+=(const neumaier_accumulator& other) {
+        add(other.m_sum);
+        m_c += other.m_c;
+        return *this;
+    }
+
+    constexpr U value() const { return U(Rep(m_sum + m_c)); }
+
+private:
+    using Rep = typename U::rep;
+
+    // The compensation adds up many rounding errors, and in a float it would
+    // lose accuracy of its own after about 1/epsilon additions, so reps
+    // narrower than double keep it in a double
+    using Compensation = std::conditional_t<(sizeof(Rep) < sizeof(double)), double, Rep>;
+
+    constexpr void add(Rep x) {
+        Rep t = m_sum + x;
+        if ((m_sum < 0 ? -m_sum : m_sum) >= (x < 0 ? -x : x)) {
+            m_c += (m_sum - t) + x;
+        } else {
+            m_c += (x - t) + m_sum;
+        }
+        m_sum = t;
+    }
+
+    Rep m_sum = 0;
+    Compensation m_c = 0;
+};
+
+namespace detail
+{
+
+template <typename U>
+concept floating_unit = is_unit<U>::value && treat_as_floating_point<typename U::rep>::value;
+
+// True if a contiguous range of U can be summed in vector lanes
+template <typename U>
+constexpr bool has_sum_lanes = std::is_same_v<typename U::rep, double> && simd::floats<double>::template supports<double>;
+
+// Independent sums in each lane of several registers, to hide the latency of
+// each addition. Each strategy has the same form, a sum and a compensation.
+inline constexpr std::size_t sum_registers = 4;
+
+template <typename Strategy, typename L>
+struct lane_sums
+{
+    using reg = typename L::reg;
+
+    reg s[sum_registers];
+    reg c[sum_registers];
+
+    lane_sums() {
+        for (std::size_t k = 0; k < sum_registers; ++k) {
+            s[k] = L::set1(0);
+            c[k] = L::set1(0);
+        }
+    }
+
+    void add(std::size_t k, reg x) {
+        if constexpr (std::is_same_v<Strategy, kahan_t>) {
+            reg y = L::sub(x, c[k]);
+            reg t = L::add(s[k], y);
+            c[k] = L::sub(L::sub(t, s[k]), y);
+            s[k] = t;
+        } else if constexpr (std::is_same_v<Strategy, neumaier_t>) {
+            // TwoSum: e is exactly the rounding error of s + x
+            reg t = L::add(s[k], x);
+            reg z = L::sub(t, s[k]);
+            reg e = L::add(L::sub(s[k], L::sub(t, z)), L::sub(x, z));
+            c[k] = L::add(c[k], e);
+            s[k] = t;
+        } else {
+            s[k] = L::add(s[k], x);
+        }
+    }
+
+    // Combines every lane with a scalar Neumaier sum
+    double total() const {
+        alignas(64) double sums[sum_registers * L::width];
+        alignas(64) double comps[sum_registers * L::width];
+        for (std::size_t k = 0; k < sum_registers; ++k) {
+            L::store(sums + k * L::width, s[k]);
+            L::store(comps + k * L::width, c[k]);
+        }
+        neumaier_accumulator<quantity<double, std::ratio<1>>> acc;
+        for (std::size_t i = 0; i < sum_registers * L::width; ++i) {
+            acc += quantity<double, std::ratio<1>>(sums[i]);
+        }
+        double correction = 0;
+        for (std::size_t i = 0; i < sum_registers * L::width; ++i) {
+            correction += std::is_same_v<Strategy, kahan_t> ? -comps[i] : comps[i];
+        }
+        return acc.value().count() + correction;
+    }
+};
+
+template <typename Strategy, typename L = simd::floats<double>>
+double sum_lanes(const double* p, std::size_t n) {
+    constexpr std::size_t step = sum_registers * L::width;
+    lane_sums<Strategy, L> sums;
+
+    std::size_t i = 0;
+    for (; i + step <= n; i += step) {
+        for (std::size_t k = 0; k < sum_registers; ++k) {
+            sums.add(k, L::load(p + i + k * L::width));
+        }
+    }
+    for (; i + L::width <= n; i += L::width) {
+        sums.add(0, L::load(p + i));
+    }
+    double tail[L::width] = {};
+    for (std::size_t j = 0; i + j < n; ++j) {
+        tail[j] = p[i + j];
+    }
+    sums.add(1, L::load(tail));
+    return sums.total();
+}
+
+// Blocks at or below this size are summed directly. Small enough that their
+// error stays low, and large enough to keep the lanes busy.
+inline constexpr std::size_t pairwise_block = 1024;
+
+template <typename U>
+U sum_pairwise(const U* p, std::size_t n) {
+    if (n <= pairwise_block) {
+        if constexpr (has_sum_lanes<U>) {
+            return U(sum_lanes<naive_t>(reinterpret_cast<const double*>(p), n));
+        } else {
+            U total = U::zero();
+            for (std::size_t i = 0; i < n; ++i) {
+                total += p[i];
+            }
+            return total;
+        }
+    }
+    std::size_t half = n / 2;
+    return sum_pairwise(p, half) + sum_pairwise(p + half, n - half);
+}
+
+template <typename Accumulator, typename R>
+auto sum_scalar(R&& r) {
+    Accumulator acc;
+    for (const auto& u : r) {
+        acc += u;
+    }
+    return acc.value();
+}
+
+} // namespace detail
+
+// Sums a range of floating point units with the given strategy, and returns
+// the sum in the range's unit type. pairwise needs a contiguous range.
+template <std::ranges::input_range R, typename Strategy = neumaier_t>
+requires detail::floating_unit<std::ranges::range_value_t<R>> &&
+    (std::is_same_v<Strategy, naive_t> || std::is_same_v<Strategy, kahan_t> ||
+     std::is_same_v<Strategy, neumaier_t> || (std::is_same_v<Strategy, pairwise_t> && std::ranges::contiguous_range<R>))
+auto sum(R&& r, Strategy = Strategy()) {
+    using U = std::ranges::range_value_t<R>;
+
+    if constexpr (std::is_same_v<Strategy, pairwise_t>) {
+        return detail::sum_pairwise(std::ranges::data(r), std::size_t(std::ranges::size(r)));
+    } else if constexpr (std::ranges::contiguous_range<R> && detail::has_sum_lanes<U>) {
+        static_assert(detail::check_rep_layout<U>());
+        return U(detail::sum_lanes<Strategy>(reinterpret_cast<const double*>(std::ranges::data(r)), std::size_t(std::ranges::size(r))));
+    } else if constexpr (std::is_same_v<Strategy, kahan_t>) {
+        return detail::sum_scalar<kahan_accumulator<U>>(r);
+    } else if constexpr (std::is_same_v<Strategy, neumaier_t>) {
+        return detail::sum_scalar<neumaier_accumulator<U>>(r);
+    } else {
+        U total = U::zero();
+        for (const auto& u : r) {
+            total += u;
+        }
+        return total;
+    }
+}
+
+namespace detail
+{
+
+#if defined(__SIZEOF_INT128__)
+__extension__ using int128 = __int128;
+__extension__ using uint128 = unsigned __int128;
+#endif
+
+template <typename Rep>
+concept integer_rep = std::is_integral_v<Rep> && !std::is_same_v<Rep, bool>;
+
+// The narrowest of the 64 and 128-bit integers with the signedness of Rep that
+// holds the sum of max_count values of Rep. The sum of n values below 2^digits
+// in magnitude is at most 2^(digits + bit_width(n - 1)) in magnitude.
+template <typename Rep, std::uint64_t max_count>
+constexpr auto choose_accumulator() {
+    constexpr int bits = std::numeric_limits<Rep>::digits + (max_count ? std::bit_width(max_count - 1) : 0);
+    if constexpr (bits <= std::numeric_limits<std::int64_t>::digits + !std::is_signed_v<Rep>) {
+        return std::conditional_t<std::is_signed_v<Rep>, std::int64_t, std::uint64_t>();
+    } else {
+#if defined(__SIZEOF_INT128__)
+        return std::conditional_t<std::is_signed_v<Rep>, int128, uint128>();
+#else
+        static_assert(bits <= 64, "the sum may overflow 64 bits, and there is no 128-bit integer");
+        return std::conditional_t<std::is_signed_v<Rep>, std::int64_t, std::uint64_t>();
+#endif
+    }
+}
+
+} // namespace detail
+
+// The default bound on the number of elements su::accumulate and su::reduce
+// add, with which 32-bit reps are summed in 64 bits
+inline constexpr std::uint64_t default_max_count = std::numeric_limits<std::uint32_t>::max();
+
+// The rep in which su::accumulate sums up to MaxCount values of Rep
+template <typename Rep, std::uint64_t MaxCount = default_max_count>
+requires detail::integer_rep<Rep>
+using accumulator_rep_t = decltype(detail::choose_accumulator<Rep, MaxCount>());
+
+namespace detail::simd
+{
+
+// Lanes that add elements of T into wider lanes, which are flushed into the
+// accumulator often enough that they cannot overflow. add() adds width
+// elements, and total() sums the lanes.
+template <typename T>
+struct widening
+{
+    static constexpr bool supported = false;
+};
+
+#if defined(__AVX512F__)
+
+// The sum of the 64-bit lanes, modulo 2^64. As in units_bulk.hpp, the
+// AVX-512 code here uses zero-masked forms and avoids
+// _mm512_reduce_add_epi64, which draw spurious -Wuninitialized warnings from
+// GCC 12.
+inline std::uint64_t sum_lanes(__m512i v) {
+    std::uint64_t lanes[8];
+    _mm512_storeu_si512(lanes, v);
+    std::uint64_t total = 0;
+    for (std::uint64_t x : lanes) {
+        total += x;
+    }
+    return total;
+}
+
+template <typename T>
+requires (std::is_same_v<T, std::int32_t> || std::is_same_v<T, std::uint32_t>)
+struct widening<T>
+{
+    static constexpr bool supported = true;
+    static constexpr std::size_t width = 16;
+    using reg = __m512i;
+
+    static reg zero() { return _mm512_setzero_si512(); }
+
+    static reg add(reg acc, const T* p) {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 8));
+        if constexpr (std::is_signed_v<T>) {
+            return _mm512_add_epi64(acc, _mm512_add_epi64(_mm512_maskz_cvtepi32_epi64(0xFF, lo), _mm512_maskz_cvtepi32_epi64(0xFF, hi)));
+        } else {
+            return _mm512_add_epi64(acc, _mm512_add_epi64(_mm512_maskz_cvtepu32_epi64(0xFF, lo), _mm512_maskz_cvtepu32_epi64(0xFF, hi)));
+        }
+    }
+
+    template <typename Acc>
+    static Acc total(reg acc) {
+        return Acc(std::conditional_t<std::is_signed_v<T>, std::int64_t, std::uint64_t>(sum_lanes(acc)));
+    }
+};
+
+#if defined(__SIZEOF_INT128__)
+// Splits each element into its high and low 32 bits, which are summed in
+// separate 64-bit lanes and combined in 128 bits
+template <typename T>
+requires (std::is_same_v<T, std::int64_t> || std::is_same_v<T, std::uint64_t>)
+struct widening<T>
+{
+    static constexpr bool supported = true;
+    static constexpr std::size_t width = 8;
+
+    struct reg
+    {
+        __m512i high;
+        __m512i low;
+    };
+
+    static reg zero() { return {_mm512_setzero_si512(), _mm512_setzero_si512()}; }
+
+    static reg add(reg acc, const T* p) {
+        __m512i v = _mm512_loadu_si512(p);
+        __m512i high = std::is_signed_v<T> ? _mm512_maskz_srai_epi64(0xFF, v, 32) : _mm512_maskz_srli_epi64(0xFF, v, 32);
+        __m512i low = _mm512_and_si512(v, _mm512_set1_epi64(0xFFFFFFFF));
+        return {_mm512_add_epi64(acc.high, high), _mm512_add_epi64(acc.low, low)};
+    }
+
+    template <typename Acc>
+    static Acc total(reg acc) {
+        Acc high = Acc(std::conditional_t<std::is_signed_v<T>, std::int64_t, std::uint64_t>(sum_lanes(acc.high)));
+        Acc low = Acc(sum_lanes(acc.low));
+        return high * (Acc(1) << 32) + low;
+    }
+};
+#endif
+
+#elif defined(__AVX2__)
+
+template <typename T>
+requires (std::is_same_v<T, std::int32_t> || std::is_same_v<T, std::uint32_t>)
+struct widening<T>
+{
+    static constexpr bool supported = true;
+    static constexpr std::size_t width = 8;
+    using reg = __m256i;
+
+    static reg zero() { return _mm256_setzero_si256(); }
+
+    static reg add(reg acc, const T* p) {
+        __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4));
+        if constexpr (std::is_signed_v<T>) {
+            return _mm256_add_epi64(acc, _mm256_add_epi64(_mm256_cvtepi32_epi64(lo), _mm256_cvtepi32_epi64(hi)));
+        } else {
+            return _mm256_add_epi64(acc, _mm256_add_epi64(_mm256_cvtepu32_epi64(lo), _mm256_cvtepu32_epi64(hi)));
+        }
+    }
+
+    template <typename Acc>
+    static Acc total(reg acc) {
+        std::conditional_t<std::is_signed_v<T>, std::int64_t, std::uint64_t> lanes[4];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+        return Acc(lanes[0]) + Acc(lanes[1]) + Acc(lanes[2]) + Acc(lanes[3]);
+    }
+};
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+template <>
+struct widening<std::int32_t>
+{
+    static constexpr bool supported = true;
+    static constexpr std::size_t width = 4;
+    using reg = int64x2_t;
+
+    static reg zero() { return vdupq_n_s64(0); }
+    static reg add(reg acc, const std::int32_t* p) { return vpadalq_s32(acc, vld1q_s32(p)); }
+
+    template <typename Acc>
+    static Acc total(reg acc) { return Acc(vaddvq_s64(acc)); }
+};
+
+template <>
+struct widening<std::uint32_t>
+{
+    static constexpr bool supported = true;
+    static constexpr std::size_t width = 4;
+    using reg = uint64x2_t;
+
+    static reg zero() { return vdupq_n_u64(0); }
+    static reg add(reg acc, const std::uint32_t* p) { return vpadalq_u32(acc, vld1q_u32(p)); }
+
+    template <typename Acc>
+    static Acc total(reg acc) { return Acc(vaddvq_u64(acc)); }
+};
+
+#endif
+
+// Elements added to the lanes between flushes. Each 64-bit lane then sums at
+// most 2^24 values below 2^32 in magnitude.
+inline constexpr std::size_t widening_block = std::size_t(1) << 28;
+
+// Sums as many leading elements as the lanes can handle into acc, and returns
+// how many were summed
+template <typename Acc, typename T>
+std::size_t accumulate(const T* p, std::size_t n, Acc& acc) {
+    using L = widening<T>;
+    std::size_t i = 0;
+    if constexpr (L::supported) {
+        while (n - i >= L::width) {
+            std::size_t end = i + std::min(widening_block, (n - i) / L::width * L::width);
+            // Two registers, to hide the latency of each addition
+            auto a = L::zero();
+            auto b = L::zero();
+            for (; i + 2 * L::width <= end; i += 2 * L::width) {
+                a = L::add(a, p + i);
+                b = L::add(b, p + i + L::width);
+            }
+            for (; i < end; i += L::width) {
+                a = L::add(a, p + i);
+            }
+            acc += L::template total<Acc>(a) + L::template total<Acc>(b);
+        }
+    }
+    return i;
+}
+
+} // namespace detail::simd
+
+// Sums a range of integer units in a rep that cannot overflow for up to
+// MaxCount elements, and returns the sum in that rep and the range's scale
+template <std::uint64_t MaxCount = default_max_count, std::ranges::input_range R>
+requires is_unit<std::ranges::range_value_t<R>>::value && detail::integer_rep<typename std::ranges::range_value_t<R>::rep>
+constexpr auto accumulate(R&& r) {
+    using U = std::ranges::range_value_t<R>;
+    using Rep = typename U::rep;
+    using Acc = accumulator_rep_t<Rep, MaxCount>;
+    using Result = unit<typename U::tag, Acc, typename U::scale>;
+
+    Acc total = 0;
+    if constexpr (std::ranges::contiguous_range<R>) {
+        static_assert(detail::check_rep_layout<U>());
+        std::size_t n = std::size_t(std::ranges::size(r));
+        assert(n <= MaxCount);
+
+        std::size_t i = 0;
+        if (!std::is_constant_evaluated()) {
+            i = detail::simd::accumulate(reinterpret_cast<const Rep*>(std::ranges::data(r)), n, total);
+        }
+        for (; i < n; ++i) {
+            total += std::ranges::data(r)[i].count();
+        }
+    } else {
+        for (const auto& u : r) {
+            total += u.count();
+        }
+    }
+    return Result(total);
+}
+
+// Sums a range of integer units as su::accumulate does, and converts the sum
+// to Result with unit_cast. Throws std::overflow_error if Result's rep is an
+// integer that cannot hold the sum once converted to Result's scale, so such
+// a call is never a constant expression.
+template <typename Result, std::uint64_t MaxCount = default_max_count, std::ranges::input_range R>
+requires is_unit<Result>::value && is_unit<std::ranges::range_value_t<R>>::value &&
+    std::same_as<typename Result::tag, typename std::ranges::range_value_t<R>::tag> &&
+    detail::integer_rep<typename std::ranges::range_value_t<R>::rep>
+constexpr Result reduce(R&& r) {
+    using Rep = typename Result::rep;
+    auto sum = accumulate<MaxCount>(std::forward<R>(r));
+    if constexpr (treat_as_floating_point<Rep>::value) {
+        return unit_cast<Result>(sum);
+    } else {
+        // Converted to Result's scale in the accumulator rep, and only then narrowed
+        using Acc = typename decltype(sum)::rep;
+        Acc wide = unit_cast<unit<typename Result::tag, Acc, typename Result::scale>>(sum).count();
+        Rep narrow = static_cast<Rep>(wide);
+        if (Acc(narrow) != wide || (narrow < Rep(0)) != (wide < Acc(0))) {
+            throw std::overflow_error("su::reduce: the sum does not fit in the result's rep");
+        }
+        return Result(narrow);
+    }
+}
+
+// The tag of the square of Tag, for tags whose square has no tag of its own
+template <typename Tag>
+struct squared_t {};
+
+namespace detail
+{
+
+// The symbol of a tag followed by "²", in brackets if it is made of several
+// symbols, e.g. "W²" or "(m/s)²"
+template <typename Tag>
+struct squared_symbol_writer
+{
+    static constexpr void write(text_sink& sink) {
+        if constexpr (is_composite_symbol<Tag>) {
+            sink.put("(");
+            sink.put(unit_symbol<Tag>::value);
+            sink.put(")");
+        } else {
+            sink.put(unit_symbol<Tag>::value);
+        }
+        sink.put("²");
+    }
+};
+
+template <typename Tag>
+struct square_tag { using type = squared_t<Tag>; };
+
+template <typename Tag>
+requires requires { typename ops::mul<Tag, Tag>::type; }
+struct square_tag<Tag> { using type = typename ops::mul<Tag, Tag>::type; };
+
+} // namespace detail
+
+// Written with the prefix in brackets, e.g. "M(W²)" for the square of kW
+template <typename Tag>
+requires has_symbol<Tag>
+struct unit_symbol<squared_t<Tag>>
+{
+    static constexpr auto value = detail::static_text<detail::squared_symbol_writer<Tag>>::chars.data();
+    static constexpr bool composite = true;
+};
+
+// The tag of Tag * Tag, as declared with SU_MUL or derived by units_dim.hpp,
+// or su::squared_t<Tag> if there is none
+template <typename Tag>
+using square_tag_t = typename detail::square_tag<Tag>::type;
+
+template <typename U>
+requires is_unit<U>::value && std::is_arithmetic_v<typename U::rep>
+class welford_accumulator;
+
+namespace detail
+{
+
+// True if a contiguous range of U can be taken in vector lanes of doubles,
+// which hold every value of the rep exactly
+template <typename U>
+constexpr bool has_statistics_lanes = simd::floats<double>::template supports<typename U::rep> &&
+    std::numeric_limits<typename U::rep>::digits <= std::numeric_limits<double>::digits;
+
+// Elements per block. Each block's deviations are taken from the mean of the
+// blocks before it, so that their squares sum without cancelling.
+inline constexpr std::size_t statistics_block = 1024;
+
+inline constexpr std::size_t statistics_registers = 2;
+
+struct welford_access
+{
+    // Adds the first n elements of p, where n is a multiple of the lanes
+    // taken per step, and returns n
+    template <typename U, typename L = simd::floats<double>>
+    static std::size_t add_lanes(welford_accumulator<U>& acc, const typename U::rep* p, std::size_t n) {
+        using reg = typename L::reg;
+        constexpr std::size_t step = statistics_registers * L::width;
+        n -= n % step;
+
+        for (std::size_t first = 0; first < n; first += statistics_block) {
+            std::size_t count = std::min(statistics_block, n - first);
+            const auto* q = p + first;
+            double base = acc.m_count ? acc.m_mean : double(q[0]);
+            reg shift = L::set1(base);
+            reg s1[statistics_registers];
+            reg s2[statistics_registers];
+            reg lo[statistics_registers];
+            reg hi[statistics_registers];
+            for (std::size_t k = 0; k < statistics_registers; ++k) {
+                s1[k] = L::set1(0);
+                s2[k] = L::set1(0);
+                lo[k] = L::load(q);
+                hi[k] = lo[k];
+            }
+            for (std::size_t i = 0; i < count; i += step) {
+                for (std::size_t k = 0; k < statistics_registers; ++k) {
+                    reg x = L::load(q + i + k * L::width);
+                    reg d = L::sub(x, shift);
+                    s1[k] = L::add(s1[k], d);
+                    s2[k] = L::add(s2[k], L::mul(d, d));
+                    lo[k] = L::min(lo[k], x);
+                    hi[k] = L::max(hi[k], x);
+                }
+            }
+
+            alignas(64) double lanes[4][step];
+            for (std::size_t k = 0; k < statistics_registers; ++k) {
+                L::store(lanes[0] + k * L::width, s1[k]);
+                L::store(lanes[1] + k * L::width, s2[k]);
+                L::store(lanes[2] + k * L::width, lo[k]);
+                L::store(lanes[3] + k * L::width, hi[k]);
+            }
+            double sum = 0;
+            double squares = 0;
+            double min = lanes[2][0];
+            double max = lanes[3][0];
+            for (std::size_t j = 0; j < step; ++j) {
+                sum += lanes[0][j];
+                squares += lanes[1][j];
+                min = std::min(min, lanes[2][j]);
+                max = std::max(max, lanes[3][j]);
+            }
+            double d = sum / double(count);
+            acc.merge(count, base + d, squares - sum * d, typename U::rep(min), typename U::rep(max));
+        }
+        return n;
+    }
+};
+
+} // namespace detail
+
+// The count, mean, variance and extremes of a stream of units, updated in one
+// pass. The mean and standard deviation are in U's tag and scale, and the
+// variance in the square of both, each with a double rep. The extremes are
+// kept in U. Values are added with +=, and accumulators with + or +=.
+template <typename U>
+requires is_unit<U>::value && std::is_arithmetic_v<typename U::rep>
+class welford_accumulator
+{
+public:
+    using value_type = U;
+    using mean_type = unit<typename U::tag, double, typename U::scale>;
+    using variance_type = unit<square_tag_t<typename U::tag>, double, std::ratio_multiply<typename U::scale, typename U::scale>>;
+
+    constexpr welford_accumulator() = default;
+
+    template <typename Rep2, typename Scale2>
+    requires std::is_convertible_v<unit<typename U::tag, Rep2, Scale2>, U>
+    constexpr welford_accumulator& operator+=(unit<typename U::tag, Rep2, Scale2> u) {
+        Rep r = U(u).count();
+        double x = double(r);
+        ++m_count;
+        double delta = x - m_mean;
+        m_mean += delta / double(m_count);
+        m_m2 += delta * (x - m_mean);
+        m_min = m_count == 1 || r < m_min ? r : m_min;
+        m_max = m_count == 1 || r > m_max ? r : m_max;
+        return *this;
+    }
+
+    // Adds the values held by another accumulator, e.g. from another thread
+    constexpr welford_accumulator& operator+=(const welford_accumulator& other) {
+        if (other.m_count) {
+            merge(other.m_count, other.m_mean, other.m_m2, other.m_min, other.m_max);
+        }
+        return *this;
+    }
+
+    friend constexpr welford_accumulator operator+(welford_accumulator a, const welford_accumulator& b) {
+        return a += b;
+    }
+
+    constexpr std::uint64_t count() const noexcept { return m_count; }
+
+    // Each of these is zero if no values were added
+    constexpr mean_type mean() const noexcept { return mean_type(m_mean); }
+    constexpr U min() const noexcept { return U(m_count ? m_min : Rep(0)); }
+    constexpr U max() const noexcept { return U(m_count ? m_max : Rep(0)); }
+
+    // The population variance, the mean squared deviation from the mean
+    constexpr variance_type variance() const noexcept {
+        return variance_type(m_count ? m_m2 / double(m_count) : 0.0);
+    }
+
+    // The unbiased estimate of the variance of the values' distribution,
+    // dividing by n - 1. Zero for fewer than two values.
+    constexpr variance_type sample_variance() const noexcept {
+        return variance_type(m_count > 1 ? m_m2 / double(m_count - 1) : 0.0);
+    }
+
+    mean_type stddev() const { return mean_type(std::sqrt(variance().count())); }
+    mean_type sample_stddev() const { return mean_type(std::sqrt(sample_variance().count())); }
+
+private:
+    using Rep = typename U::rep;
+
+    friend struct detail::welford_access;
+
+    // Chan's formula for the union of two sets of values
+    constexpr void merge(std::uint64_t n, double mean, double m2, Rep min, Rep max) {
+        if (m_count == 0) {
+            m_count = n;
+            m_mean = mean;
+            m_m2 = m2;
+            m_min = min;
+            m_max = max;
+            return;
+        }
+        std::uint64_t total = m_count + n;
+        double delta = mean - m_mean;
+        double weight = double(n) / double(total);
+        m_mean += delta * weight;
+        m_m2 += m2 + delta * delta * double(m_count) * weight;
+        m_min = min < m_min ? min : m_min;
+        m_max = max > m_max ? max : m_max;
+        m_count = total;
+    }
+
+    std::uint64_t m_count = 0;
+    double m_mean = 0;
+    double m_m2 = 0; // The sum of squared deviations from the mean
+    Rep m_min = 0;
+    Rep m_max = 0;
+};
+
+// The statistics of a range of units. Contiguous ranges of reps that a
+// double holds exactly are taken in vector lanes.
+template <std::ranges::input_range R>
+requires is_unit<std::ranges::range_value_t<R>>::value && std::is_arithmetic_v<typename std::ranges::range_value_t<R>::rep>
+constexpr welford_accumulator<std::ranges::range_value_t<R>> statistics(R&& r) {
+    using U = std::ranges::range_value_t<R>;
+    welford_accumulator<U> acc;
+    if constexpr (std::ranges::contiguous_range<R> && detail::has_statistics_lanes<U>) {
+        static_assert(detail::check_rep_layout<U>());
+        std::size_t n = std::size_t(std::ranges::size(r));
+        std::size_t i = 0;
+        if (!std::is_constant_evaluated()) {
+            i = detail::welford_access::add_lanes<U>(acc, reinterpret_cast<const typename U::rep*>(std::ranges::data(r)), n);
+        }
+        for (; i < n; ++i) {
+            acc += std::ranges::data(r)[i];
+        }
+    } else {
+        for (const auto& u : r) {
+            acc += u;
+        }
+    }
+    return acc;
+}
+
+} // namespace su
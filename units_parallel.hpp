@@ -0,0 +1,309 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "units_numeric.hpp"
+
+// Multi-threaded versions of the bulk operations, for arrays too large for one
+// core to get through quickly. Each operation splits its arrays into chunks of
+// about SU_PARALLEL_CHUNK_SIZE bytes, so that a chunk stays in a core's cache
+// while it is worked on. It runs each chunk through the single-threaded vector
+// kernel on a su::thread_pool. Threads take the next chunk from a shared
+// counter as they finish one, so faster threads take more chunks, as they
+// would with work stealing. Reductions keep one partial result per chunk and
+// merge them in the type the single-threaded reduction would use.
+
+// Bytes of the largest array touched per chunk
+#ifndef SU_PARALLEL_CHUNK_SIZE
+#define SU_PARALLEL_CHUNK_SIZE 262144
+#endif
+
+namespace su
+{
+
+// A fixed set of worker threads that run the tasks of one call to run() at a
+// time. The calling thread runs tasks too, so a pool of size n uses n - 1
+// workers.
+class thread_pool
+{
+public:
+    explicit thread_pool(std::size_t threads = std::max(1u, std::thread::hardware_concurrency())) {
+        for (std::size_t i = 1; i < threads; ++i) {
+            m_workers.emplace_back([this] { work(); });
+        }
+    }
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    ~thread_pool() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto& t : m_workers) {
+            t.join();
+        }
+    }
+
+    // A pool with a thread for each hardware thread
+    static thread_pool& instance() {
+        static thread_pool pool;
+        return pool;
+    }
+
+    std::size_t size() const noexcept {
+        return m_workers.size() + 1;
+    }
+
+    // Calls f(i) for every i in [0, n) on the pool's threads, and returns when
+    // every call has finished. If calls throw, the first exception is
+    // rethrown. Calls from several threads run one after another. Must not be
+    // called from inside f.
+    template <typename F>
+    void run(std::size_t n, F&& f) {
+        std::lock_guard serial(m_run_mutex);
+        job j([](void* f, std::size_t i) { (*static_cast<std::remove_reference_t<F>*>(f))(i); }, &f, n);
+        {
+            std::lock_guard lock(m_mutex);
+            m_job = &j;
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        j.work();
+
+        std::unique_lock lock(m_mutex);
+        m_done.wait(lock, [&] { return m_busy == 0; });
+        m_job = nullptr;
+        lock.unlock();
+        if (j.error) {
+            std::rethrow_exception(j.error);
+        }
+    }
+
+private:
+    struct job
+    {
+        job(void (*call)(void*, std::size_t), void* f, std::size_t n) : call(call), f(f), n(n) {}
+
+        void (*call)(void*, std::size_t);
+        void* f;
+        std::size_t n;
+        std::atomic<std::size_t> next{0};
+        std::mutex error_mutex;
+        std::exception_ptr error;
+
+        void work() {
+            for (std::size_t i = next.fetch_add(1, std::memory_order_relaxed); i < n; i = next.fetch_add(1, std::memory_order_relaxed)) {
+                try {
+                    call(f, i);
+                } catch (...) {
+                    std::lock_guard lock(error_mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+        }
+    };
+
+    // A worker joins each job it wakes up for. run() waits for every worker
+    // that joined to leave, so that the job outlives them. A worker that wakes
+    // after the job has finished finds no job, and waits for the next one.
+    void work() {
+        std::uint64_t seen = 0;
+        std::unique_lock lock(m_mutex);
+        for (;;) {
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop) {
+                return;
+            }
+            seen = m_generation;
+            job* j = m_job;
+            if (!j) {
+                continue;
+            }
+            ++m_busy;
+            lock.unlock();
+            j->work();
+            lock.lock();
+            if (--m_busy == 0) {
+                m_done.notify_one();
+            }
+        }
+    }
+
+    std::mutex m_run_mutex;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    job* m_job = nullptr;
+    std::uint64_t m_generation = 0;
+    std::size_t m_busy = 0;
+    bool m_stop = false;
+    std::vector<std::thread> m_workers;
+};
+
+namespace detail::parallel
+{
+
+// Elements per chunk, for arrays whose largest element is Size bytes. A
+// multiple of 64 elements, so that every chunk starts as aligned as the array.
+template <std::size_t Size>
+inline constexpr std::size_t chunk_size = std::max<std::size_t>(64, SU_PARALLEL_CHUNK_SIZE / Size / 64 * 64);
+
+// Calls f(first, count) for each chunk of [0, n)
+template <std::size_t Size, typename F>
+void for_each_chunk(thread_pool& pool, std::size_t n, F&& f) {
+    constexpr std::size_t chunk = chunk_size<Size>;
+    std::size_t chunks = (n + chunk - 1) / chunk;
+    if (chunks <= 1 || pool.size() == 1) {
+        for (std::size_t c = 0; c < chunks; ++c) {
+            f(c * chunk, std::min(chunk, n - c * chunk));
+        }
+    } else {
+        pool.run(chunks, [&](std::size_t c) { f(c * chunk, std::min(chunk, n - c * chunk)); });
+    }
+}
+
+// Computes f(first, count) for each chunk of [0, n), and returns the results
+// in chunk order, so that merging them does not depend on the scheduling
+template <std::size_t Size, typename T, typename F>
+std::vector<T> map_chunks(thread_pool& pool, std::size_t n, F&& f) {
+    std::vector<T> partial((n + chunk_size<Size> - 1) / chunk_size<Size>);
+    for_each_chunk<Size>(pool, n, [&](std::size_t first, std::size_t count) { partial[first / chunk_size<Size>] = f(first, count); });
+    return partial;
+}
+
+} // namespace detail::parallel
+
+namespace parallel
+{
+
+// Converts every element of in as su::unit_cast(in, out) does, writing the
+// results to the front of out
+template <typename To, typename From, std::size_t E1, std::size_t E2, typename Policy = strict_t>
+requires is_unit<std::remove_const_t<From>>::value && std::same_as<typename To::tag, typename From::tag> &&
+    (std::same_as<Policy, strict_t> || std::same_as<Policy, fast_math_t>)
+std::span<To> unit_cast(std::span<From, E1> in, std::span<To, E2> out, Policy policy = Policy(),
+    thread_pool& pool = thread_pool::instance()) {
+    assert(out.size() >= in.size());
+    detail::parallel::for_each_chunk<std::max(sizeof(From), sizeof(To))>(pool, in.size(), [&](std::size_t first, std::size_t count) {
+        su::unit_cast(in.subspan(first, count), out.subspan(first, count), policy);
+    });
+    return out.first(in.size());
+}
+
+// Writes a[i] * b[i] to out[i], in the unit operator* gives, e.g. a derived
+// unit for units of two tags declared with SU_MUL
+template <typename A, typename B, std::size_t E1, std::size_t E2, typename T, std::size_t E3>
+requires is_unit<std::remove_const_t<A>>::value && is_unit<std::remove_const_t<B>>::value &&
+    std::same_as<T, decltype(std::declval<A>() * std::declval<B>())>
+std::span<T> multiply(std::span<A, E1> a, std::span<B, E2> b, std::span<T, E3> out, thread_pool& pool = thread_pool::instance()) {
+    using RA = typename std::remove_const_t<A>::rep;
+    using RB = typename std::remove_const_t<B>::rep;
+    static_assert(detail::check_rep_layout<std::remove_const_t<A>>() && detail::check_rep_layout<std::remove_const_t<B>>() &&
+        detail::check_rep_layout<T>());
+    assert(a.size() == b.size() && out.size() >= a.size());
+
+    detail::parallel::for_each_chunk<std::max({sizeof(A), sizeof(B), sizeof(T)})>(pool, a.size(), [&](std::size_t first, std::size_t count) {
+        std::size_t i = detail::simd::zip<std::multiplies<>, T, std::remove_const_t<A>, std::remove_const_t<B>>(
+            reinterpret_cast<const RA*>(a.data() + first), reinterpret_cast<const RB*>(b.data() + first),
+            reinterpret_cast<typename T::rep*>(out.data() + first), count);
+        for (; i < count; ++i) {
+            out[first + i] = a[first + i] * b[first + i];
+        }
+    });
+    return out.first(a.size());
+}
+
+// Sums floating point units as su::sum(r, strategy) does within each chunk,
+// and adds the chunks' sums with a Neumaier sum
+template <typename U, std::size_t E, typename Strategy = neumaier_t>
+requires detail::floating_unit<std::remove_const_t<U>>
+std::remove_const_t<U> sum(std::span<U, E> r, Strategy strategy = Strategy(), thread_pool& pool = thread_pool::instance()) {
+    using V = std::remove_const_t<U>;
+    auto partial = detail::parallel::map_chunks<sizeof(V), V>(pool, r.size(), [&](std::size_t first, std::size_t count) {
+        return su::sum(r.subspan(first, count), strategy);
+    });
+    neumaier_accumulator<V> total;
+    for (const auto& p : partial) {
+        total += p;
+    }
+    return total.value();
+}
+
+// Sums integer units as su::accumulate does, in the same accumulator rep
+template <std::uint64_t MaxCount = default_max_count, typename U, std::size_t E>
+requires is_unit<std::remove_const_t<U>>::value && detail::integer_rep<typename std::remove_const_t<U>::rep>
+auto accumulate(std::span<U, E> r, thread_pool& pool = thread_pool::instance()) {
+    using V = std::remove_const_t<U>;
+    using Result = unit<typename V::tag, accumulator_rep_t<typename V::rep, MaxCount>, typename V::scale>;
+    assert(r.size() <= MaxCount);
+    auto partial = detail::parallel::map_chunks<sizeof(V), Result>(pool, r.size(), [&](std::size_t first, std::size_t count) {
+        return su::accumulate<MaxCount>(r.subspan(first, count));
+    });
+    Result total = Result::zero();
+    for (const auto& p : partial) {
+        total += p;
+    }
+    return total;
+}
+
+// The statistics of an array, as su::statistics computes them within each
+// chunk, with the chunks' accumulators merged in order
+template <typename U, std::size_t E>
+requires is_unit<std::remove_const_t<U>>::value && std::is_arithmetic_v<typename std::remove_const_t<U>::rep>
+welford_accumulator<std::remove_const_t<U>> statistics(std::span<U, E> r, thread_pool& pool = thread_pool::instance()) {
+    using V = std::remove_const_t<U>;
+    auto partial = detail::parallel::map_chunks<sizeof(V), welford_accumulator<V>>(pool, r.size(), [&](std::size_t first, std::size_t count) {
+        return su::statistics(r.subspan(first, count));
+    });
+    welford_accumulator<V> total;
+    for (const auto& p : partial) {
+        total += p;
+    }
+    return total;
+}
+
+// The smallest and largest elements of a non-empty array, compared by count.
+// Where several elements are equal, which one is returned is unspecified, as
+// they have the same value.
+template <typename U, std::size_t E>
+requires is_unit<std::remove_const_t<U>>::value
+std::ranges::minmax_result<std::remove_const_t<U>> minmax(std::span<U, E> r, thread_pool& pool = thread_pool::instance()) {
+    using V = std::remove_const_t<U>;
+    using Rep = typename V::rep;
+    static_assert(detail::check_rep_layout<V>());
+    assert(!r.empty());
+
+    auto partial = detail::parallel::map_chunks<sizeof(V), std::ranges::minmax_result<Rep>>(pool, r.size(),
+        [&](std::size_t first, std::size_t count) {
+            // Written as selections so that the compiler vectorizes the loop
+            const Rep* p = reinterpret_cast<const Rep*>(r.data() + first);
+            Rep lo = p[0];
+            Rep hi = p[0];
+            for (std::size_t i = 1; i < count; ++i) {
+                lo = p[i] < lo ? p[i] : lo;
+                hi = p[i] > hi ? p[i] : hi;
+            }
+            return std::ranges::minmax_result<Rep>{lo, hi};
+        });
+    std::ranges::minmax_result<Rep> result = partial[0];
+    for (const auto& p : partial) {
+        result.min = p.min < result.min ? p.min : result.min;
+        result.max = p.max > result.max ? p.max : result.max;
+    }
+    return {V(result.min), V(result.max)};
+}
+
+} // namespace parallel
+
+} // namespace su
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <chrono>
+#include <compare>
+#include "units.hpp"
+
+// A point in time on a clock, as std::chrono::time_point, measured as a unit
+// since the clock's epoch. The clock is any tag type, so points of hardware,
+// PTP or other clocks that std::chrono has no clock for keep their clock in
+// their type, and points of different clocks cannot be mixed. Subtracting two
+// points of a clock gives the unit between them, and adding a unit to a point
+// gives a point. Each operation is the same arithmetic on the counts as for
+// the units themselves.
+//
+// A clock shares its epoch with a std::chrono clock if it is one, or if it
+// names one as chrono_clock, e.g.
+//
+//     struct ptp_clock { using chrono_clock = std::chrono::system_clock; };
+//
+// Points of such clocks with a duration unit convert to and from that clock's
+// std::chrono::time_point under the same rules as the unit and
+// std::chrono::duration.
+
+namespace su
+{
+
+namespace detail
+{
+
+template <typename Clock>
+struct chrono_clock_of {};
+
+template <typename Clock>
+requires std::chrono::is_clock_v<Clock>
+struct chrono_clock_of<Clock> { using type = Clock; };
+
+template <typename Clock>
+requires (!std::chrono::is_clock_v<Clock>) && requires { typename Clock::chrono_clock; }
+struct chrono_clock_of<Clock> { using type = typename Clock::chrono_clock; };
+
+} // namespace detail
+
+// The std::chrono clock whose epoch Clock shares
+template <typename Clock>
+using chrono_clock_t = typename detail::chrono_clock_of<Clock>::type;
+
+template <typename Clock, typename Unit>
+requires is_unit<Unit>::value
+class point
+{
+public:
+    using clock = Clock;
+    using duration = Unit;
+    using rep = typename Unit::rep;
+    using scale = typename Unit::scale;
+
+    // The clock's epoch
+    constexpr point() : m_d(Unit::zero()) {}
+
+    constexpr explicit point(const Unit& d) : m_d(d) {}
+
+    template <typename Unit2>
+    requires std::is_convertible_v<Unit2, Unit>
+    constexpr point(const point<Clock, Unit2>& p) : m_d(p.time_since_epoch()) {}
+
+    // C only delays naming the chrono clock until the constructor is used, as
+    // clocks without one are allowed
+    template <typename Duration, typename C = Clock>
+    requires std::is_convertible_v<Duration, Unit>
+    constexpr point(const std::chrono::time_point<chrono_clock_t<C>, Duration>& t) : m_d(t.time_since_epoch()) {}
+
+    static constexpr point min() { return point(Unit::min()); }
+    static constexpr point max() { return point(Unit::max()); }
+
+    constexpr Unit time_since_epoch() const {
+        return m_d;
+    }
+
+    template <typename Rep2, typename Scale2>
+    requires std::is_convertible_v<unit<typename Unit::tag, Rep2, Scale2>, Unit>
+    constexpr point& operator+=(const unit<typename Unit::tag, Rep2, Scale2>& d) {
+        m_d += Unit(d);
+        return *this;
+    }
+
+    template <typename Rep2, typename Scale2>
+    requires std::is_convertible_v<unit<typename Unit::tag, Rep2, Scale2>, Unit>
+    constexpr point& operator-=(const unit<typename Unit::tag, Rep2, Scale2>& d) {
+        m_d -= Unit(d);
+        return *this;
+    }
+
+    template <typename Duration, typename C = Clock>
+    requires std::is_convertible_v<Unit, Duration>
+    constexpr operator std::chrono::time_point<chrono_clock_t<C>, Duration>() const {
+        return std::chrono::time_point<chrono_clock_t<C>, Duration>(Duration(m_d));
+    }
+
+private:
+    Unit m_d;
+};
+
+template <typename T>
+struct is_point : std::false_type {};
+
+template <typename Clock, typename Unit>
+struct is_point<point<Clock, Unit>> : std::true_type {};
+
+// Converts a point to another unit of the same tag, with unit_cast
+template <typename To, typename Clock, typename Unit>
+requires is_unit<To>::value && std::same_as<typename To::tag, typename Unit::tag>
+constexpr point<Clock, To> point_cast(const point<Clock, Unit>& p) {
+    return point<Clock, To>(unit_cast<To>(p.time_since_epoch()));
+}
+
+template <typename Clock, typename Unit1, typename Unit2>
+constexpr auto operator-(const point<Clock, Unit1>& a, const point<Clock, Unit2>& b) {
+    return a.time_since_epoch() - b.time_since_epoch();
+}
+
+template <typename Clock, typename Unit, typename Rep2, typename Scale2>
+constexpr auto operator+(const point<Clock, Unit>& p, const unit<typename Unit::tag, Rep2, Scale2>& d) {
+    auto t = p.time_since_epoch() + d;
+    return point<Clock, decltype(t)>(t);
+}
+
+template <typename Clock, typename Unit, typename Rep2, typename Scale2>
+constexpr auto operator+(const unit<typename Unit::tag, Rep2, Scale2>& d, const point<Clock, Unit>& p) {
+    return p + d;
+}
+
+template <typename Clock, typename Unit, typename Rep2, typename Scale2>
+constexpr auto operator-(const point<Clock, Unit>& p, const unit<typename Unit::tag, Rep2, Scale2>& d) {
+    auto t = p.time_since_epoch() - d;
+    return point<Clock, decltype(t)>(t);
+}
+
+template <typename Clock, typename Unit1, typename Unit2>
+constexpr bool operator==(const point<Clock, Unit1>& a, const point<Clock, Unit2>& b) {
+    return a.time_since_epoch() == b.time_since_epoch();
+}
+
+template <typename Clock, typename Unit1, typename Unit2>
+constexpr auto operator<=>(const point<Clock, Unit1>& a, const point<Clock, Unit2>& b) {
+    return a.time_since_epoch() <=> b.time_since_epoch();
+}
+
+} // namespace su
+
+namespace std
+{
+
+template <typename Clock, typename Unit1, typename Unit2>
+struct common_type<su::point<Clock, Unit1>, su::point<Clock, Unit2>>
+{
+    using type = su::point<Clock, common_type_t<Unit1, Unit2>>;
+};
+
+} // namespace std
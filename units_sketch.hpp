@@ -0,0 +1,531 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "units_id.hpp"
+
+// A quantile sketch of units, DDSketch (Masson, Rim and Lee, 2019). Each value
+// v is counted in the bucket ceil(log_gamma |v|), where gamma = (1 + a) /
+// (1 - a) for a relative accuracy a, so that every quantile comes back within
+// a relative error of a of the true one. Positive and negative values have
+// their own buckets, and values too small to have an index are counted as
+// zero. Memory depends only on the range of the values and not on how many
+// there are. When a sketch reaches its bucket limit, its buckets nearest zero
+// are folded together, which only loses accuracy for the smallest values.
+//
+// Sketches with the same accuracy merge exactly, and serialize to a compact
+// binary form that records the unit type, so that sketches can be merged
+// across processes.
+
+namespace su
+{
+
+enum class sketch_errc
+{
+    ok = 0,
+    not_a_sketch, // The bytes do not start with the sketch magic
+    unsupported,  // Another version of the format
+    wrong_type,   // The sketch is of another unit type
+    corrupt       // The bytes end early or hold an invalid value
+};
+
+constexpr std::string_view sketch_error_message(sketch_errc ec) {
+    switch (ec) {
+        case sketch_errc::ok: return "ok";
+        case sketch_errc::not_a_sketch: return "not a sketch";
+        case sketch_errc::unsupported: return "unsupported version";
+        case sketch_errc::wrong_type: return "sketch of another unit type";
+        case sketch_errc::corrupt: return "corrupt sketch";
+    }
+    return "unknown error";
+}
+
+namespace detail::sketch
+{
+
+inline constexpr char magic[4] = {'S', 'U', 'D', 'D'};
+inline constexpr std::uint8_t version = 1;
+
+// Bounds on the parameters of a sketch. Above min_accuracy, the index of any
+// finite double is well within an int.
+inline constexpr double min_accuracy = 1e-6;
+inline constexpr std::size_t max_buckets_limit = std::size_t(1) << 24;
+
+// Counts for a contiguous range of bucket indexes, which grows as values
+// arrive. Beyond max_buckets, the lowest buckets are folded into the lowest
+// one that is kept.
+class store
+{
+public:
+    bool empty() const noexcept {
+        return m_counts.empty();
+    }
+
+    std::size_t size() const noexcept {
+        return m_counts.size();
+    }
+
+    int first() const noexcept {
+        return m_offset;
+    }
+
+    std::uint64_t operator[](int index) const noexcept {
+        return m_counts[std::size_t(index - m_offset)];
+    }
+
+    void add(int index, std::uint64_t n, std::size_t max_buckets) {
+        if (index < m_offset && m_counts.size() >= max_buckets) {
+            m_counts.front() += n; // Already folded into the lowest bucket
+            return;
+        }
+        if (m_counts.empty() || index < m_offset || index >= m_offset + int(m_counts.size())) {
+            extend(index, index, max_buckets);
+        }
+        m_counts[std::size_t(std::max(index, m_offset) - m_offset)] += n;
+    }
+
+    void merge(const store& other, std::size_t max_buckets) {
+        if (other.empty()) {
+            return;
+        }
+        extend(other.m_offset, other.m_offset + int(other.m_counts.size()) - 1, max_buckets);
+        for (std::size_t i = 0; i < other.m_counts.size(); ++i) {
+            m_counts[std::size_t(std::max(other.m_offset + int(i), m_offset) - m_offset)] += other.m_counts[i];
+        }
+    }
+
+    void assign(int offset, std::vector<std::uint64_t> counts) {
+        m_offset = offset;
+        m_counts = std::move(counts);
+    }
+
+    const std::vector<std::uint64_t>& counts() const noexcept {
+        return m_counts;
+    }
+
+private:
+    // Makes room for the indexes [lo, hi], folding the lowest buckets if the
+    // range would be wider than max_buckets. Growing upwards, the usual case
+    // for a new largest value, is amortized by the vector's growth.
+    void extend(int lo, int hi, std::size_t max_buckets) {
+        if (!m_counts.empty()) {
+            lo = std::min(lo, m_offset);
+            hi = std::max(hi, m_offset + int(m_counts.size()) - 1);
+        }
+        lo = int(std::max<long long>(lo, (long long)hi - (long long)max_buckets + 1));
+
+        std::uint64_t folded = 0;
+        if (m_counts.empty()) {
+            m_offset = lo;
+        } else if (lo > m_offset) {
+            auto k = std::ptrdiff_t(std::min(std::size_t(lo - m_offset), m_counts.size()));
+            folded = std::accumulate(m_counts.begin(), m_counts.begin() + k, std::uint64_t(0));
+            m_counts.erase(m_counts.begin(), m_counts.begin() + k);
+            m_offset = lo;
+        } else if (lo < m_offset) {
+            m_counts.insert(m_counts.begin(), std::size_t(m_offset - lo), 0);
+            m_offset = lo;
+        }
+        m_counts.resize(std::size_t(hi - lo + 1));
+        m_counts.front() += folded;
+    }
+
+    std::vector<std::uint64_t> m_counts;
+    int m_offset = 0;
+};
+
+class writer
+{
+public:
+    explicit writer(std::span<std::byte> out) : m_out(out) {}
+
+    void put(const void* p, std::size_t n) {
+        if (m_size + n <= m_out.size()) {
+            std::memcpy(m_out.data() + m_size, p, n);
+        }
+        m_size += n;
+    }
+
+    void put_u64(std::uint64_t v) {
+        unsigned char bytes[8];
+        for (int i = 0; i < 8; ++i) {
+            bytes[i] = static_cast<unsigned char>(v >> (8 * i));
+        }
+        put(bytes, 8);
+    }
+
+    void put_double(double v) {
+        put_u64(std::bit_cast<std::uint64_t>(v));
+    }
+
+    // LEB128, 7 bits per byte
+    void put_varint(std::uint64_t v) {
+        do {
+            unsigned char b = static_cast<unsigned char>(v & 0x7F);
+            v >>= 7;
+            if (v) {
+                b |= 0x80;
+            }
+            put(&b, 1);
+        } while (v);
+    }
+
+    void put_signed(std::int64_t v) {
+        put_varint((std::uint64_t(v) << 1) ^ std::uint64_t(v >> 63));
+    }
+
+    void put_store(const store& s) {
+        put_signed(s.first());
+        put_varint(s.size());
+        for (std::uint64_t c : s.counts()) {
+            put_varint(c);
+        }
+    }
+
+    // The number of bytes the whole sketch needs, which is more than the
+    // output if it was too small
+    std::size_t size() const noexcept {
+        return m_size;
+    }
+
+private:
+    std::span<std::byte> m_out;
+    std::size_t m_size = 0;
+};
+
+class reader
+{
+public:
+    explicit reader(std::span<const std::byte> in) : m_in(in) {}
+
+    bool get(void* p, std::size_t n) {
+        if (m_in.size() - m_pos < n) {
+            return false;
+        }
+        std::memcpy(p, m_in.data() + m_pos, n);
+        m_pos += n;
+        return true;
+    }
+
+    bool get_u64(std::uint64_t& v) {
+        unsigned char bytes[8];
+        if (!get(bytes, 8)) {
+            return false;
+        }
+        v = 0;
+        for (int i = 0; i < 8; ++i) {
+            v |= std::uint64_t(bytes[i]) << (8 * i);
+        }
+        return true;
+    }
+
+    bool get_double(double& v) {
+        std::uint64_t bits;
+        if (!get_u64(bits)) {
+            return false;
+        }
+        v = std::bit_cast<double>(bits);
+        return true;
+    }
+
+    bool get_varint(std::uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            unsigned char b;
+            if (!get(&b, 1)) {
+                return false;
+            }
+            v |= std::uint64_t(b & 0x7F) << shift;
+            if (!(b & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool get_signed(std::int64_t& v) {
+        std::uint64_t u;
+        if (!get_varint(u)) {
+            return false;
+        }
+        v = std::int64_t(u >> 1) ^ -std::int64_t(u & 1);
+        return true;
+    }
+
+    bool get_store(store& s, std::size_t max_buckets) {
+        std::int64_t offset;
+        std::uint64_t n;
+        // Each count takes at least one byte, which bounds n before anything
+        // is allocated for it
+        if (!get_signed(offset) || !get_varint(n) || n > max_buckets || n > remaining() ||
+            offset < std::numeric_limits<int>::min() ||
+            offset + std::int64_t(n) > std::numeric_limits<int>::max()) {
+            return false;
+        }
+        std::vector<std::uint64_t> counts(n);
+        for (auto& c : counts) {
+            if (!get_varint(c)) {
+                return false;
+            }
+        }
+        s.assign(int(offset), std::move(counts));
+        return true;
+    }
+
+    std::size_t remaining() const noexcept {
+        return m_in.size() - m_pos;
+    }
+
+    bool done() const noexcept {
+        return m_pos == m_in.size();
+    }
+
+private:
+    std::span<const std::byte> m_in;
+    std::size_t m_pos = 0;
+};
+
+} // namespace detail::sketch
+
+// A DDSketch of U. Values of the same tag at any scale are converted to U's
+// scale when they are added. Quantiles are returned as U, rounded to the
+// nearest count for integer reps.
+template <typename U>
+requires is_unit<U>::value && std::is_arithmetic_v<typename U::rep>
+class ddsketch
+{
+public:
+    using value_type = U;
+
+    // relative_accuracy must be in [1e-6, 1), so that every bucket index fits
+    // in an int. max_buckets bounds the buckets of positive and of negative
+    // values separately, and must be in [1, 2^24].
+    explicit ddsketch(double relative_accuracy = 0.01, std::size_t max_buckets = 2048) :
+        m_accuracy(relative_accuracy),
+        m_max_buckets(max_buckets),
+        m_gamma((1 + relative_accuracy) / (1 - relative_accuracy)),
+        m_inv_log_gamma(1 / std::log(m_gamma)),
+        m_min_indexable(std::numeric_limits<double>::min() * m_gamma) {
+        assert(relative_accuracy >= detail::sketch::min_accuracy && relative_accuracy < 1);
+        assert(max_buckets > 0 && max_buckets <= detail::sketch::max_buckets_limit);
+    }
+
+    template <typename Rep2, typename Scale2>
+    requires std::is_arithmetic_v<Rep2>
+    void add(unit<typename U::tag, Rep2, Scale2> u, std::uint64_t n = 1) {
+        double v = unit_cast<unit<typename U::tag, double, typename U::scale>>(u).count();
+        if (v > m_min_indexable) {
+            m_positive.add(index(v), n, m_max_buckets);
+        } else if (v < -m_min_indexable) {
+            m_negative.add(index(-v), n, m_max_buckets);
+        } else {
+            m_zeros += n;
+        }
+        m_min = m_count ? std::min(m_min, v) : v;
+        m_max = m_count ? std::max(m_max, v) : v;
+        m_count += n;
+    }
+
+    // Adds the values of another sketch. Returns false, and changes nothing,
+    // if it has another relative accuracy.
+    bool merge(const ddsketch& other) {
+        if (other.m_accuracy != m_accuracy) {
+            return false;
+        }
+        if (other.m_count == 0) {
+            return true;
+        }
+        m_positive.merge(other.m_positive, m_max_buckets);
+        m_negative.merge(other.m_negative, m_max_buckets);
+        m_zeros += other.m_zeros;
+        m_min = m_count ? std::min(m_min, other.m_min) : other.m_min;
+        m_max = m_count ? std::max(m_max, other.m_max) : other.m_max;
+        m_count += other.m_count;
+        return true;
+    }
+
+    // The value at quantile q in [0, 1], e.g. 0.99 for the 99th percentile.
+    // Quantiles 0 and 1 are the exact min() and max(). Zero if the sketch is
+    // empty.
+    U quantile(double q) const {
+        if (m_count == 0) {
+            return U::zero();
+        }
+        if (q <= 0 || q >= 1) {
+            return q <= 0 ? min() : max();
+        }
+        double rank = q * double(m_count - 1);
+        double v = m_max;
+        std::uint64_t seen = 0;
+        bool found = false;
+
+        // From the most negative value up to the most positive
+        for (int i = m_negative.first() + int(m_negative.size()) - 1; !found && i >= m_negative.first(); --i) {
+            seen += m_negative[i];
+            if (double(seen) > rank) {
+                v = -value(i);
+                found = true;
+            }
+        }
+        if (!found) {
+            seen += m_zeros;
+            if (double(seen) > rank) {
+                v = 0;
+                found = true;
+            }
+        }
+        for (int i = m_positive.first(); !found && i < m_positive.first() + int(m_positive.size()); ++i) {
+            seen += m_positive[i];
+            if (double(seen) > rank) {
+                v = value(i);
+                found = true;
+            }
+        }
+        return to_unit(std::clamp(v, m_min, m_max));
+    }
+
+    std::uint64_t count() const noexcept {
+        return m_count;
+    }
+
+    U min() const noexcept {
+        return to_unit(m_count ? m_min : 0);
+    }
+
+    U max() const noexcept {
+        return to_unit(m_count ? m_max : 0);
+    }
+
+    double relative_accuracy() const noexcept {
+        return m_accuracy;
+    }
+
+    // The number of buckets in use, each of which takes 8 bytes
+    std::size_t bucket_count() const noexcept {
+        return m_positive.size() + m_negative.size();
+    }
+
+    // Writes the sketch to out, and returns the number of bytes it takes,
+    // which is more than out.size() if out was too small, in which case the
+    // contents of out are unspecified. The counts are written as variable
+    // length integers.
+    std::size_t serialize(std::span<std::byte> out) const
+    requires detail::identifiable<U>
+    {
+        detail::sketch::writer w(out);
+        w.put(detail::sketch::magic, sizeof(detail::sketch::magic));
+        w.put(&detail::sketch::version, 1);
+        w.put_u64(type_id<U>);
+        w.put_double(m_accuracy);
+        w.put_varint(m_max_buckets);
+        w.put_varint(m_count);
+        w.put_varint(m_zeros);
+        w.put_double(m_min);
+        w.put_double(m_max);
+        w.put_store(m_positive);
+        w.put_store(m_negative);
+        return w.size();
+    }
+
+    std::vector<std::byte> serialize() const
+    requires detail::identifiable<U>
+    {
+        std::vector<std::byte> bytes(serialize(std::span<std::byte>()));
+        serialize(std::span(bytes));
+        return bytes;
+    }
+
+    // Replaces the sketch with one read from in, which must hold a sketch of
+    // U and nothing else. Leaves the sketch unchanged on error.
+    sketch_errc deserialize(std::span<const std::byte> in)
+    requires detail::identifiable<U>
+    {
+        detail::sketch::reader r(in);
+        char magic[4];
+        std::uint8_t version;
+        if (!r.get(magic, sizeof(magic)) || std::memcmp(magic, detail::sketch::magic, sizeof(magic)) != 0) {
+            return sketch_errc::not_a_sketch;
+        }
+        if (!r.get(&version, 1)) {
+            return sketch_errc::corrupt;
+        }
+        if (version != detail::sketch::version) {
+            return sketch_errc::unsupported;
+        }
+        std::uint64_t id;
+        if (!r.get_u64(id)) {
+            return sketch_errc::corrupt;
+        }
+        if (id != type_id<U>) {
+            return sketch_errc::wrong_type;
+        }
+
+        double accuracy;
+        std::uint64_t max_buckets;
+        if (!r.get_double(accuracy) || !(accuracy >= detail::sketch::min_accuracy && accuracy < 1) ||
+            !r.get_varint(max_buckets) || max_buckets == 0 || max_buckets > detail::sketch::max_buckets_limit) {
+            return sketch_errc::corrupt;
+        }
+        ddsketch s(accuracy, std::size_t(max_buckets));
+        std::uint64_t total;
+        if (!r.get_varint(total) || !r.get_varint(s.m_zeros) || !r.get_double(s.m_min) || !r.get_double(s.m_max) ||
+            !r.get_store(s.m_positive, s.m_max_buckets) || !r.get_store(s.m_negative, s.m_max_buckets) || !r.done()) {
+            return sketch_errc::corrupt;
+        }
+        std::uint64_t sum = s.m_zeros;
+        for (std::uint64_t c : s.m_positive.counts()) {
+            sum += c;
+        }
+        for (std::uint64_t c : s.m_negative.counts()) {
+            sum += c;
+        }
+        if (sum != total || (total && !(s.m_min <= s.m_max))) {
+            return sketch_errc::corrupt;
+        }
+        s.m_count = total;
+        *this = std::move(s);
+        return sketch_errc::ok;
+    }
+
+private:
+    int index(double v) const noexcept {
+        return int(std::ceil(std::log(v) * m_inv_log_gamma));
+    }
+
+    // The value of bucket i with the least relative error to any value in it
+    double value(int i) const noexcept {
+        return 2 * std::pow(m_gamma, i) / (m_gamma + 1);
+    }
+
+    static U to_unit(double v) noexcept {
+        if constexpr (treat_as_floating_point<typename U::rep>::value) {
+            return U(typename U::rep(v));
+        } else {
+            return U(typename U::rep(std::llround(v)));
+        }
+    }
+
+    double m_accuracy;
+    std::size_t m_max_buckets;
+    double m_gamma;
+    double m_inv_log_gamma;
+    double m_min_indexable;
+    detail::sketch::store m_positive;
+    detail::sketch::store m_negative;
+    std::uint64_t m_zeros = 0;
+    std::uint64_t m_count = 0;
+    double m_min = 0;
+    double m_max = 0;
+};
+
+} // namespace su